@@ -4,10 +4,34 @@
 // Examples of memory dumps
 //
 #include "memDump.h"
+#include "memDumpAsync.h"
+#include "memDumpCacheLine.h"
+#include "memDumpCallSites.h"
+#include "memDumpCapture.h"
+#include "memDumpCrash.h"
+#include "memDumpFile.h"
+#include "memDumpFormat.h"
+#include "memDumpGraph.h"
+#include "memDumpLayout.h"
+#include "memDumpProcess.h"
+#include "memDumpRegistry.h"
+#include "memDumpSearch.h"
+#include "memDumpSnapshot.h"
+#include "memDumpSpans.h"
+#include "memDumpWatch.h"
 #include <cstddef>
 #include <iostream>
 #include <memory>
 #include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace std::string_literals;
 ////////////////////////////////////////////////////////////////////////////////
@@ -17,6 +41,8 @@ void logFuncName(const char fn[]) {
 #define LOGFNAME logFuncName(__func__);
 ////////////////////////////////////////////////////////////////////////////////
 class test_t {
+  friend struct memDump::FieldLayout<test_t>;
+
 private:
   // no padding with this layout
   char   a;  // 1 byte
@@ -52,6 +78,21 @@ public:
   }
 };
 
+MEMDUMP_LAYOUT(test_t, MEMDUMP_FIELD(a), MEMDUMP_FIELD(i8), MEMDUMP_FIELD(c), MEMDUMP_FIELD(b), MEMDUMP_FIELD(d));
+
+// the same fields in an order that needs padding
+struct padded_t {
+  char   a {0x11};
+  long   d {0x4044444444444441};
+  short  c {0x3031};
+  int8_t i8 {0x55};
+  int    b {0x20222221};
+};
+
+MEMDUMP_LAYOUT(padded_t, MEMDUMP_FIELD(a), MEMDUMP_FIELD(d), MEMDUMP_FIELD(c), MEMDUMP_FIELD(i8), MEMDUMP_FIELD(b));
+static_assert(memDump::paddingOf<test_t>() == 0);
+static_assert(memDump::suggestedSizeOf<padded_t>() == sizeof(test_t));
+
 class C {
 public:
   // We don't want these objects allocated on the heap: cannot use new() and
@@ -361,6 +402,364 @@ void dumpMemoryCase_21() {
   ptr->~nonaddressable();
 }
 
+void dumpMemoryCase_22() {
+  LOGFNAME
+  // the dumps are copied to the ring of the dumper, and formatted and printed
+  // by its background thread
+  memDump::AsyncDumper dumper;
+  long l {0x0102030405060708};
+  test_t t;
+
+  std::cout << "dumping asynchronously stack memory at " << &l << " and at " << &t << "\n";
+  DMVA(dumper, l);
+  DMPA(dumper, &t, test_t);
+  // wait for the background thread to print them
+  dumper.flush();
+}
+
+void dumpMemoryCase_23() {
+  LOGFNAME
+  // a forked child has the same layout of the address space: dump its copy
+  // of v, changed after the fork, by pid and address
+  long v {0x1111111111111111};
+  int ready[2];
+  if (pipe(ready) < 0) {
+    return;
+  }
+
+  const pid_t child {fork()};
+  if (0 == child) {
+    v = 0x2222222222222222;
+    if (write(ready[1], "r", 1) == 1) {
+      pause();
+    }
+    _exit(EXIT_SUCCESS);
+  }
+  char c {};
+  if ((child > 0) && (read(ready[0], &c, 1) == 1)) {
+    std::cout << "dumping memory at " << &v << " of child process " << std::dec << child << "\n";
+    memDump::dumpProcessMemory(child, reinterpret_cast<memDump::uptr_t>(&v), sizeof(v));
+  }
+  if (child > 0) {
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+  }
+  close(ready[0]);
+  close(ready[1]);
+}
+
+void dumpMemoryCase_24() {
+  LOGFNAME
+  // snapshot a buffer before and after changing a few bytes: the diff only
+  // prints the rows with changes
+  unsigned char buffer[256] {};
+  for (std::size_t i {0}; i < sizeof(buffer); ++i) {
+    buffer[i] = static_cast<unsigned char>(i);
+  }
+  const memDump::Snapshot before {memDump::Snapshot::capture(buffer)};
+  buffer[5] = 0xFF;
+  buffer[6] = 0xFF;
+  buffer[200] = 0x00;
+
+  std::cout << "diffing stack memory at " << static_cast<void*>(buffer) << "\n";
+  memDump::dumpSnapshotDiff(before, memDump::Snapshot::capture(buffer));
+}
+
+void dumpMemoryCase_25() {
+  LOGFNAME
+  // a value in the middle of a zeroed buffer, with 2 KB of context: the runs
+  // of zero rows before and after it are printed as *
+  std::vector<long> zeros(1024, 0);
+  zeros[512] = 0x0102030405060708;
+  memDump::DumpOptions options {memDump::currentDumpOptions()};
+  options.contextOption = memDump::DUMP_CONTEXT_OPTION::FixedContext;
+  options.preBufferSize = 2048;
+  options.postBufferSize = 2048;
+  options.collapseRepeatedRows = true;
+
+  std::cout << "dumping heap memory at " << &zeros[512] << " in a zeroed buffer\n";
+  memDump::dumpMemory(&zeros[512], sizeof(long), options);
+}
+
+void dumpMemoryCase_26() {
+  LOGFNAME
+  // capture two variables to a log, then render the log as mem-dump --render
+  // would, e.g. on another machine
+  const char* path {"/tmp/mem-dump-capture.log"};
+  unlink(path);
+  long l {0x0102030405060708};
+  test_t t;
+  {
+    memDump::CaptureWriter writer {path};
+    writer.capture(l);
+    writer.capture(&t, sizeof(t));
+  }
+
+  std::cout << "rendering the capture log " << path << "\n";
+  memDump::renderCaptureFile(path);
+  unlink(path);
+}
+
+void dumpMemoryCase_27() {
+  LOGFNAME
+  // the fields of the objects in their own colors, and their padding
+  test_t t;
+  padded_t p;
+
+  std::cout << "dumping the layout of stack memory at " << &t << " and at " << &p << "\n";
+  memDump::dumpLayout(t);
+  memDump::dumpLayout(p);
+}
+
+void dumpMemoryCase_28() {
+  LOGFNAME
+  // the counters of two threads next to each other share a cache line; the
+  // padded ones don't
+  struct counters_t {
+    long produced {0x1111111111111111};
+    long consumed {0x2222222222222222};
+    alignas(64) long paddedProduced {0x3333333333333333};
+    alignas(64) long paddedConsumed {0x4444444444444444};
+  };
+  counters_t c;
+  memDump::DumpOptions options {memDump::currentDumpOptions()};
+  options.cacheLineSize = memDump::cacheLineSize();
+
+  std::cout << "dumping stack memory at " << &c << " with its cache lines\n";
+  memDump::dumpMemory(&c, sizeof(c), options);
+
+  const memDump::OwnedRegion regions[] {
+    {&c.produced, sizeof(c.produced), 1, "produced"},
+    {&c.consumed, sizeof(c.consumed), 2, "consumed"},
+    {&c.paddedProduced, sizeof(c.paddedProduced), 1, "paddedProduced"},
+    {&c.paddedConsumed, sizeof(c.paddedConsumed), 2, "paddedConsumed"},
+  };
+  memDump::dumpFalseSharing(regions, std::size(regions), options);
+}
+
+void dumpMemoryCase_29() {
+  LOGFNAME
+  // dump into a buffer on the stack, then straight to the standard output:
+  // nothing is allocated, and the dump takes a single write()
+  long l {0x0102030405060708};
+  char text[4096];
+  memDump::BufferSink buffer {text, sizeof(text)};
+
+  std::cout << "dumping stack memory at " << &l << " into a buffer of " << std::dec << sizeof(text) << " bytes\n";
+  memDump::dumpMemory(&l, sizeof(l), memDump::currentDumpOptions(), "long", buffer);
+  std::cout << std::dec << buffer.view().size() << " bytes formatted, truncated: " << buffer.truncated() << "\n";
+
+  std::cout << "dumping stack memory at " << &l << " to file descriptor " << STDOUT_FILENO << "\n";
+  std::cout.flush();
+  memDump::FdSink out {STDOUT_FILENO};
+  memDump::dumpMemory(&l, sizeof(l), memDump::currentDumpOptions(), "long", out);
+}
+
+void dumpMemoryCase_30() {
+  LOGFNAME
+  // a forked child writes past the end of a buffer into a page it can't
+  // access: the crash handler dumps the memory around the faulting address,
+  // with the inaccessible bytes as ??, and the stack, then the child dies of
+  // the SIGSEGV
+  std::cout.flush();
+  const pid_t child {fork()};
+  if (0 == child) {
+    const long pageSize {sysconf(_SC_PAGESIZE)};
+    auto* const pages {static_cast<unsigned char*>(mmap(nullptr, 2 * pageSize, PROT_READ | PROT_WRITE,
+                                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0))};
+    if ((MAP_FAILED == pages) || (mprotect(pages + pageSize, pageSize, PROT_NONE) < 0)) {
+      _exit(EXIT_FAILURE);
+    }
+    std::memset(pages, 0xAB, pageSize);
+    memDump::CrashHandlerOptions crashOptions {};
+    crashOptions.fd = STDOUT_FILENO;
+    memDump::installCrashHandler(crashOptions);
+    *reinterpret_cast<volatile unsigned char*>(pages + pageSize + 8) = 0;
+    _exit(EXIT_SUCCESS);
+  }
+  int status {};
+  if ((child > 0) && (waitpid(child, &status, 0) == child)) {
+    if (WIFSIGNALED(status)) {
+      std::cout << "\nchild process " << std::dec << child << " killed by signal " << WTERMSIG(status) << "\n";
+    } else {
+      std::cout << "\nchild process " << std::dec << child << " exited with " << WEXITSTATUS(status) << "\n";
+    }
+  }
+}
+
+void dumpMemoryCase_31() {
+  LOGFNAME
+  // the same object in the formats for tools: xxd, a C array, JSON
+  test_t t;
+  memDump::DumpOptions options {memDump::currentDumpOptions()};
+  options.contextOption = memDump::DUMP_CONTEXT_OPTION::FixedContext;
+  options.preBufferSize = 0;
+  options.postBufferSize = 0;
+
+  std::cout << "dumping stack memory at " << &t << " as xxd\n";
+  memDump::dumpMemoryAs<memDump::XxdFormat>(&t, sizeof(t), options);
+  std::cout << "dumping stack memory at " << &t << " as a C array\n";
+  memDump::dumpMemoryAs<memDump::CArrayFormat>(&t, sizeof(t), options, "test_t");
+  std::cout << "dumping stack memory at " << &t << " as JSON\n";
+  memDump::dumpMemoryAs<memDump::JsonFormat>(&t, sizeof(t), options, "test_t");
+}
+
+void dumpMemoryCase_32() {
+  LOGFNAME
+  // watch a config block and a large buffer: each check prints only the rows
+  // written since the previous one
+  struct config_t {
+    long version {1};
+    long flags {0};
+    char name[16] {"service"};
+  };
+  config_t config;
+  std::vector<unsigned char> buffer(16384, 0);
+  memDump::MemoryWatch watch {};
+  watch.watch(config);
+  watch.watch(buffer.data(), buffer.size(), "buffer");
+
+  std::cout << "watching stack memory at " << &config << " and heap memory at "
+            << static_cast<void*>(buffer.data()) << ", soft-dirty tracking: "
+            << (watch.softDirty() ? "yes" : "no") << "\n";
+  config.version = 2;
+  buffer[10000] = 0xFF;
+  watch.check();
+  std::cout << "checking again, nothing changed: " << std::dec << watch.check() << " rows\n";
+}
+
+void dumpMemoryCase_33() {
+  LOGFNAME
+  // heap objects found by type and by an address inside them
+  if (!memDump::allocationRegistryEnabled) {
+    std::cout << "configure with -DMEMDUMP_ALLOCATION_REGISTRY=ON to track the allocations\n";
+    return;
+  }
+  struct order_t : memDump::TrackedAllocation<order_t> {
+    long id {0};
+    double price {0.0};
+    int quantity {0};
+  };
+  std::vector<std::unique_ptr<order_t>> orders;
+  for (long id {1}; id <= 3; ++id) {
+    orders.emplace_back(new order_t);
+    orders.back()->id = id;
+  }
+  orders.erase(orders.begin() + 1);
+
+  // the allocations of the standard library, tagged by hand
+  std::shared_ptr<std::string> note;
+  {
+    const memDump::ScopedAllocationTag tag {"note"};
+    note = std::make_shared<std::string>("heap objects found by type");
+  }
+
+  memDump::dumpAllocationsOf<order_t>();
+  memDump::dumpAllocationAt(&orders.back()->quantity, memDump::currentDumpOptions());
+  memDump::dumpAllocations("note", memDump::currentDumpOptions());
+  const memDump::AllocationRegistryStats stats {memDump::allocationRegistryStats()};
+  std::cout << std::dec << stats.live << " live allocations, " << stats.dropped << " dropped\n";
+}
+
+void dumpMemoryCase_34() {
+  LOGFNAME
+  // find the sentinel of test_t in an array, then anywhere in the process
+  const auto tests {std::make_unique<test_t[]>(3)};
+  const memDump::BytePattern sentinel {memDump::BytePattern::of(std::int64_t {0x4044444444444441})};
+  memDump::dumpPatternMatches(sentinel, tests.get(), 3 * sizeof(test_t), memDump::currentDumpOptions());
+
+  // with wildcards: the sentinel with any low byte
+  memDump::BytePattern masked {};
+  memDump::BytePattern::parse("?? 44 44 44 44 44 44 40", masked);
+  std::vector<memDump::uptr_t> matches;
+  memDump::findPatternInMemory(masked, matches);
+  std::cout << "the masked sentinel is found " << std::dec << matches.size()
+            << " times in the process, in the 3 objects among others\n";
+}
+
+void dumpMemoryCase_35() {
+  LOGFNAME
+  // dumpMemoryCase_4() shows the pointer of a shared_ptr only: the graph
+  // shows its control block, the heap buffer of a long string, and a cycle
+  struct node_t {
+    std::shared_ptr<C> shared {std::make_shared<C>(5)};
+    std::string text {"a string too long for the small string optimization"};
+    node_t* next {nullptr};
+  };
+  const auto first {std::make_unique<node_t>()};
+  const auto second {std::make_unique<node_t>()};
+  first->next = second.get();
+  second->next = first.get();
+
+  // the second node links back to the first one, dumped once
+  memDump::dumpMemoryGraph(*first);
+}
+
+void dumpMemoryCase_36() {
+  LOGFNAME
+  // the DMV() and DMP() call sites of the examples, the most expensive first
+  if (!memDump::callSiteStatsEnabled) {
+    std::cout << "configure with -DMEMDUMP_CALLSITE_STATS=ON to count the DMV() and DMP() calls\n";
+    return;
+  }
+  long counters[4] {1, 2, 3, 4};
+  for (long& counter : counters) {
+    DMV(counter);
+  }
+  memDump::printCallSiteStats(5);
+}
+
+void dumpMemoryCase_37() {
+  LOGFNAME
+  // sampled macros, e.g. in a hot path: 1 call in 4 dumps, then at most one
+  // dump a second whatever the number of calls
+  const memDump::DumpSampling previous {memDump::dumpSampling()};
+  memDump::setDumpSampling(memDump::DumpSampling {4, 0});
+  for (long i {0}; i < 8; ++i) {
+    DMV(i);  // i is 0 and 4
+  }
+  memDump::setDumpSampling(memDump::DumpSampling {1, 1});
+  for (long i {0}; i < 1000; ++i) {
+    DMV(i);  // once, if this call site didn't dump in this second yet
+  }
+  memDump::setDumpSampling(previous);
+}
+
+void dumpMemoryCase_38() {
+  LOGFNAME
+  // nested labeled spans: a message, its header, a field of the header
+  struct header_t {
+    std::uint16_t type;
+    std::uint16_t flags;
+    std::uint32_t length;
+  };
+  struct message_t {
+    header_t header;
+    char payload[24];
+  } message {{7, 0x8001, 24}, "hello, spans"};
+  memDump::dumpMemorySpans(message, {memDump::spanOf(message, "message"),
+                                     memDump::spanOf(message.header, "header"),
+                                     memDump::spanOf(message.header.flags, "flags"),
+                                     memDump::HighlightSpan {message.payload, 12, "text"}});
+}
+
+void dumpMemoryCase_39() {
+  LOGFNAME
+  // a few elements of an array and an object on the heap in one dump: the
+  // context rows shared by the elements are printed once
+  static constexpr std::string_view labels[] {"values[1]", "values[2]", "values[5]", "values[40]"};
+  std::uint32_t values[48] {};
+  for (std::uint32_t i {0}; i < 48; ++i) {
+    values[i] = i * 0x01010101;
+  }
+  const auto object {std::make_unique<std::uint64_t>(0x1122334455667788)};
+  std::vector<memDump::HighlightSpan> ranges {memDump::spanOf(*object, "object")};
+  for (const std::size_t i : {1, 2, 5, 40}) {
+    ranges.push_back(memDump::spanOf(values[i], labels[ranges.size() - 1]));
+  }
+  memDump::dumpMemoryBatch(ranges.data(), ranges.size(), memDump::currentDumpOptions(), std::cout);
+}
+
 void runExamples() {
   dumpMemoryCase_1();
   dumpMemoryCase_2();
@@ -383,9 +782,182 @@ void runExamples() {
   dumpMemoryCase_19();
   dumpMemoryCase_20();
   dumpMemoryCase_21();
+  dumpMemoryCase_22();
+  dumpMemoryCase_23();
+  dumpMemoryCase_24();
+  dumpMemoryCase_25();
+  dumpMemoryCase_26();
+  dumpMemoryCase_27();
+  dumpMemoryCase_28();
+  dumpMemoryCase_29();
+  dumpMemoryCase_30();
+  dumpMemoryCase_31();
+  dumpMemoryCase_32();
+  dumpMemoryCase_33();
+  dumpMemoryCase_34();
+  dumpMemoryCase_35();
+  dumpMemoryCase_36();
+  dumpMemoryCase_37();
+  dumpMemoryCase_38();
+  dumpMemoryCase_39();
 }
 ////////////////////////////////////////////////////////////////////////////////
-int main () {
+// Command line modes of mem-dump; with no arguments it runs the examples
+struct commandLine {
+  pid_t pid {0};
+  std::uint64_t address {0};
+  std::string file {};
+  std::string render {};
+  std::uint64_t offset {0};
+  std::uint64_t length {0};
+  memDump::BytePattern find {};
+  std::size_t maxMatches {100};
+  memDump::DumpOptions options {};
+};
+
+[[noreturn]] void usage(const char* program) {
+  std::cerr << "usage: " << program << "                 run the examples\n"
+            << "       " << program << " --file <path> [--offset <n>] [--length <n>] [options]\n"
+            << "           dump length bytes (0: through the end) at offset in the file;\n"
+            << "           the file is mapped a window at a time\n"
+            << "       " << program << " --pid <pid> --address <a> --length <n> [options]\n"
+            << "           dump length bytes at address in the memory of process pid\n"
+            << "       " << program << " --render <path> [options]\n"
+            << "           dump the records of a capture log written by memDump::CaptureWriter\n"
+            << "       " << program << " --find <hex> | --find-text <text> --pid <pid> | --file <path> [options]\n"
+            << "           dump the matches of a pattern in the memory of process pid, or in the\n"
+            << "           file: hex bytes in memory order, ? for any nibble, e.g. \"41 44 ?? 4?\"\n"
+            << "options:\n"
+            << "  --fixed [--pre <n>] [--post <n>]  fixed context of pre/post bytes\n"
+            << "  --dynamic                         one row of context (default)\n"
+            << "  --row-width <n>                   bytes per row (default 16)\n"
+            << "  --no-color                        no highlighting colors\n"
+            << "  --color                           colors even when not on a terminal\n"
+            << "  --collapse                        print the runs of repeated rows as *\n"
+            << "  --cache-lines                     draw the boundaries of the cache lines\n"
+            << "  --max-matches <n>                 matches of --find dumped (default 100)\n"
+            << "numbers can be decimal, or hex with a 0x prefix\n";
+  std::exit(EXIT_FAILURE);
+}
+
+commandLine parseCommandLine(int argc, char* argv[]) {
+  commandLine cl {};
+  cl.options = memDump::getDefaultDumpOptions();
+
+  // the number after the option at i, up to max
+  auto number = [&](int& i, const std::uint64_t max = std::numeric_limits<std::uint64_t>::max()) -> std::uint64_t {
+    if (i + 1 >= argc) {
+      usage(argv[0]);
+    }
+    const char* const option {argv[i]};
+    const char* const value {argv[++i]};
+    // stoull() takes "-1" for the largest number, and "12abc" for 12
+    if ('-' != value[0]) {
+      try {
+        std::size_t parsed {0};
+        const std::uint64_t n {std::stoull(value, &parsed, 0)};
+        if (('\0' == value[parsed]) && (n <= max)) {
+          return n;
+        }
+      } catch (const std::logic_error&) {
+        // std::invalid_argument, or std::out_of_range
+      }
+    }
+    std::cerr << argv[0] << ": invalid number for " << option << ": " << value << "\n";
+    usage(argv[0]);
+  };
+  auto text = [&](int& i) -> std::string {
+    if (i + 1 >= argc) {
+      usage(argv[0]);
+    }
+    return argv[++i];
+  };
+
+  for (int i {1}; i < argc; ++i) {
+    const std::string arg {argv[i]};
+    if ("--pid" == arg) {
+      cl.pid = static_cast<pid_t>(number(i, std::numeric_limits<pid_t>::max()));
+    } else if ("--address" == arg) {
+      cl.address = number(i);
+    } else if ("--file" == arg) {
+      cl.file = text(i);
+    } else if ("--render" == arg) {
+      cl.render = text(i);
+    } else if ("--find" == arg) {
+      if (!memDump::BytePattern::parse(text(i), cl.find)) {
+        usage(argv[0]);
+      }
+    } else if ("--find-text" == arg) {
+      cl.find = memDump::BytePattern::text(text(i));
+      if (cl.find.empty()) {
+        usage(argv[0]);
+      }
+    } else if ("--max-matches" == arg) {
+      cl.maxMatches = number(i);
+    } else if ("--offset" == arg) {
+      cl.offset = number(i);
+    } else if ("--length" == arg) {
+      cl.length = number(i);
+    } else if ("--fixed" == arg) {
+      cl.options.contextOption = memDump::DUMP_CONTEXT_OPTION::FixedContext;
+    } else if ("--dynamic" == arg) {
+      cl.options.contextOption = memDump::DUMP_CONTEXT_OPTION::DynamicContext;
+    } else if ("--pre" == arg) {
+      cl.options.preBufferSize = number(i);
+    } else if ("--post" == arg) {
+      cl.options.postBufferSize = number(i);
+    } else if ("--row-width" == arg) {
+      cl.options.rowWidth = number(i);
+    } else if ("--no-color" == arg) {
+      cl.options.color = false;
+    } else if ("--color" == arg) {
+      cl.options.color = true;
+      cl.options.autoColor = false;
+    } else if ("--collapse" == arg) {
+      cl.options.collapseRepeatedRows = true;
+    } else if ("--cache-lines" == arg) {
+      cl.options.cacheLineSize = memDump::cacheLineSize();
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (1 != (!cl.file.empty()) + (0 != cl.pid) + (!cl.render.empty())) {
+    usage(argv[0]);  // one of --file, --pid and --render is needed
+  }
+  if (!cl.find.empty() && !cl.render.empty()) {
+    usage(argv[0]);  // --find searches a process or a file
+  }
+  if ((0 != cl.pid) && cl.find.empty() && (0 == cl.length)) {
+    std::cerr << argv[0] << ": --pid needs a --length to dump\n";
+    usage(argv[0]);
+  }
+  return cl;
+}
+
+int runCommandLine(int argc, char* argv[]) {
+  const commandLine cl {parseCommandLine(argc, argv)};
+
+  if (!cl.find.empty()) {
+    const std::size_t matches {(0 != cl.pid)
+        ? memDump::dumpProcessPatternMatches(cl.pid, cl.find, cl.options, cl.maxMatches)
+        : memDump::dumpFilePatternMatches(cl.file.c_str(), cl.find, cl.options, cl.maxMatches)};
+    return (matches > 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  if (0 != cl.pid) {
+    memDump::dumpProcessMemory(cl.pid, cl.address, cl.length, cl.options);
+    return EXIT_SUCCESS;
+  }
+  if (!cl.render.empty()) {
+    return memDump::renderCaptureFile(cl.render.c_str(), cl.options) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  return memDump::dumpFile(cl.file.c_str(), cl.offset, cl.length, cl.options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+////////////////////////////////////////////////////////////////////////////////
+int main (int argc, char* argv[]) {
+  if (argc > 1) {
+    return runCommandLine(argc, argv);
+  }
+
   memDump::checkEndianness();
   memDump::setFixedContextOption();
   runExamples();
@@ -2,17 +2,187 @@
 // memDump.cpp
 //
 #include "memDump.h"
+#include "memDumpMaps.h"
+#include "memDumpSimd.h"
+#include <array>
+#include <atomic>
 #include <bit>
+#include <cstdlib>
+#include <ctime>
+#include <cxxabi.h>
+#include <deque>
 #include <iomanip>
+#include <mutex>
+#include <string_view>
+#include <unistd.h>
 ////////////////////////////////////////////////////////////////////////////////
 namespace memDump {
-static DUMP_CONTEXT_OPTION dumpContextOption {DUMP_CONTEXT_OPTION::DynamicContext};  // default option
-static uptr_t fixedPreBufferSize  {24};  // default size
-static uptr_t fixedPostBufferSize {24};  // default size
-
 const std::string FGRED       {"\033[1;31m"};  // foreground red
 const std::string FGGREEN     {"\033[1;32m"};  // foreground green
 const std::string RESET_COLOR {"\033[0m"};
+const std::string_view RANGE_COLORS[RANGE_COLOR_COUNT] {
+  "\033[1;36m",  // cyan
+  "\033[1;33m",  // yellow
+  "\033[1;34m",  // blue
+  "\033[1;35m",  // magenta
+  "\033[1;32m",  // green
+  "\033[1;31m",  // red
+};
+
+namespace {
+// two upper-case hex digits for every byte value: "00", "01", ..., "FF"
+constexpr std::array<char, 512> hexTable {[] {
+  constexpr char digits[] {"0123456789ABCDEF"};
+  std::array<char, 512> table {};
+  for (std::size_t v {0}; v < 256; ++v) {
+    table[2 * v]     = digits[v >> 4];
+    table[2 * v + 1] = digits[v & 0xF];
+  }
+  return table;
+}()};
+
+// Formats one row of the dump into a fixed stack buffer, and writes it to the
+// sink with a single call when the row is complete
+class RowFormatter final {
+public:
+  explicit RowFormatter(Sink& sink) noexcept :
+  sink_(sink)
+  {}
+
+  ~RowFormatter() {
+    flush();
+  }
+
+  RowFormatter(const RowFormatter&) = delete;
+  RowFormatter& operator=(const RowFormatter&) = delete;
+
+  void append(const char c) noexcept {
+    buffer_[length_++] = c;
+  }
+
+  void append(const std::string_view s) noexcept {
+    std::memcpy(buffer_ + length_, s.data(), s.size());
+    length_ += s.size();
+  }
+
+  void appendByte(const byte_t b) noexcept {
+    std::memcpy(buffer_ + length_, &hexTable[2 * b], 2);
+    length_ += 2;
+  }
+
+  // the address offsets printed along the top row
+  void appendRuler(const uptr_t rowWidth, const uptr_t groupSize) noexcept {
+    append("                   ");
+    for (uptr_t i {0}; i < rowWidth; ++i) {
+      // Spaces between every group of bytes
+      if (i % groupSize == 0) {
+        append(' ');
+      }
+      append(' ');
+      append((i < 16) ? ' ' : hexTable[2 * i]);
+      append(hexTable[2 * i + 1]);
+    }
+  }
+
+  // "\n0x" followed by the 16 hex digits address and a colon
+  void appendAddress(uptr_t address) noexcept {
+    append("\n0x");
+    appendHex(address);
+    append(':');
+  }
+
+  // value in decimal, as many digits as needed
+  void appendDecimal(std::uint64_t value) noexcept {
+    char digits[20];
+    std::size_t count {0};
+    do {
+      digits[count++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value > 0);
+    while (count > 0) {
+      append(digits[--count]);
+    }
+  }
+
+  // address like a const void* printed to a std::ostream: "0x" followed by
+  // the lower-case hex digits, "0" for nullptr
+  void appendPointer(uptr_t address) noexcept {
+    if (0 == address) {
+      append('0');
+      return;
+    }
+    append("0x");
+    const int digits {static_cast<int>((std::bit_width(address) + 3) / 4)};
+    for (int i {digits - 1}; i >= 0; --i, address >>= 4) {
+      buffer_[length_ + static_cast<std::size_t>(i)] = "0123456789abcdef"[address & 0xF];
+    }
+    length_ += static_cast<std::size_t>(digits);
+  }
+
+  // the line drawn before the row at rowAddress if a cache line starts in it
+  void appendCacheLine(const uptr_t rowAddress, const uptr_t rowWidth, const uptr_t cacheLineSize) noexcept {
+    if (0 == cacheLineSize) {
+      return;
+    }
+    const uptr_t line {(rowAddress + cacheLineSize - 1) / cacheLineSize * cacheLineSize};
+    if (line - rowAddress < rowWidth) {
+      append("\n------------------- cache line 0x");
+      appendHex(line);
+    }
+  }
+
+  void flush() noexcept {
+    if (length_ > 0) {
+      sink_.write(buffer_, length_);
+      length_ = 0;
+    }
+  }
+
+private:
+  // the 16 hex digits of address
+  void appendHex(uptr_t address) noexcept {
+    for (int i {15}; i >= 0; --i, address >>= 4) {
+      buffer_[length_ + static_cast<std::size_t>(i)] = hexTable[2 * (address & 0xF) + 1];
+    }
+    length_ += 16;
+  }
+
+  // worst case of a row: cache line, address, then for each byte: group
+  // space, opening marker, color, two hex digits, reset, closing marker
+  static constexpr std::size_t capacity {52 + 20 + DumpOptions::maxRowWidth * (1 + 8 + 7 + 2 + 4 + 12)};
+
+  Sink& sink_;
+  std::size_t length_ {0};
+  char buffer_[capacity];
+};
+
+// The color of the text appended to a row: an escape sequence is appended
+// only where the color changes, not around each byte
+class RowColor final {
+public:
+  RowColor(RowFormatter& row, const std::string_view reset) noexcept :
+  row_(row),
+  reset_(reset)
+  {}
+
+  // the text appended next is in color; empty: the default one
+  void set(const std::string_view color) noexcept {
+    if (color == color_) {
+      return;
+    }
+    if (!color_.empty()) {
+      row_.append(reset_);
+    }
+    row_.append(color);
+    color_ = color;
+  }
+
+private:
+  RowFormatter& row_;
+  const std::string_view reset_;
+  std::string_view color_ {};
+};
+}  // namespace
 
 // see: https://en.cppreference.com/w/cpp/types/endian
 // since C++20
@@ -25,185 +195,673 @@ void checkEndianness() {
     std::cout << "\ncheckEndianness: mixed-endian\n";
 }
 
+namespace {
+// The process-wide default options are immutable snapshots: a setter publishes
+// a new one, and readers only do an atomic load of the current one.
+// The snapshots are never released, since readers may still use any of them;
+// a deque never moves its elements when growing at the end. A setter going
+// back to options published before reuses their snapshot, so that there are
+// only as many as distinct options, e.g. two for a toggled color
+std::mutex defaultOptionsMutex;  // serializes the setters, never taken by readers
+std::deque<DumpOptions> defaultOptionsSnapshots {DumpOptions {}};
+std::atomic<const DumpOptions*> defaultOptions {&defaultOptionsSnapshots.front()};
+
+thread_local bool threadOptionsInstalled {false};
+thread_local DumpOptions threadOptions {};
+
+template <typename F>
+DumpOptions updateDefaultDumpOptions(F&& change) {
+  const std::lock_guard<std::mutex> lock {defaultOptionsMutex};
+  DumpOptions options {*defaultOptions.load(std::memory_order_acquire)};
+  change(options);
+  auto snapshot {std::find(defaultOptionsSnapshots.begin(), defaultOptionsSnapshots.end(), options)};
+  if (defaultOptionsSnapshots.end() == snapshot) {
+    snapshot = defaultOptionsSnapshots.insert(defaultOptionsSnapshots.end(), options);
+  }
+  defaultOptions.store(&*snapshot, std::memory_order_release);
+  return options;
+}
+}  // namespace
+
+const DumpOptions& currentDumpOptions() noexcept {
+  if (threadOptionsInstalled) {
+    return threadOptions;
+  }
+  return *defaultOptions.load(std::memory_order_acquire);
+}
+
+DumpOptions setThreadDumpOptions(const DumpOptions& options) noexcept {
+  const DumpOptions previous {currentDumpOptions()};
+  threadOptions = options;
+  threadOptionsInstalled = true;
+  return previous;
+}
+
+void clearThreadDumpOptions() noexcept {
+  threadOptionsInstalled = false;
+}
+
+ScopedDumpOptions::ScopedDumpOptions(const DumpOptions& options) noexcept :
+hadThreadOptions_(threadOptionsInstalled),
+previous_(threadOptions)
+{
+  setThreadDumpOptions(options);
+}
+
+ScopedDumpOptions::~ScopedDumpOptions() {
+  threadOptions = previous_;
+  threadOptionsInstalled = hadThreadOptions_;
+}
+
+void setDefaultDumpOptions(const DumpOptions& options) {
+  updateDefaultDumpOptions([&options](DumpOptions& o) { o = options; });
+}
+
+DumpOptions getDefaultDumpOptions() noexcept {
+  return *defaultOptions.load(std::memory_order_acquire);
+}
+
+namespace detail {
+std::atomic<std::uint64_t> dumpSampling {0};
+
+bool sampleCallSite(CallSiteGate& gate, const std::uint64_t sampling) noexcept {
+  const auto everyN {static_cast<std::uint32_t>(sampling >> 32)};
+  const auto maxPerSecond {static_cast<std::uint32_t>(sampling)};
+
+  // this call is the one in everyN
+  if (everyN > 1) {
+    gate.skip.store(everyN - 1, std::memory_order_relaxed);
+  }
+  if (maxPerSecond > 0) {
+    // the coarse clock is read without a system call, in a few nanoseconds
+    timespec now {};
+    ::clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    const std::int64_t second {now.tv_sec};
+    if (gate.second.load(std::memory_order_relaxed) != second) {
+      // a race with another thread at the turn of the second lets a few
+      // more dumps through
+      gate.second.store(second, std::memory_order_relaxed);
+      gate.dumps.store(0, std::memory_order_relaxed);
+    }
+    const std::uint32_t dumps {gate.dumps.load(std::memory_order_relaxed)};
+    if (dumps >= maxPerSecond) {
+      return false;
+    }
+    gate.dumps.store(dumps + 1, std::memory_order_relaxed);
+  }
+  return true;
+}
+}  // namespace detail
+
+void setDumpSampling(const DumpSampling& sampling) noexcept {
+  const std::uint64_t everyN {(sampling.everyN > 1) ? sampling.everyN : 0U};
+  detail::dumpSampling.store((everyN << 32) | sampling.maxPerSecond, std::memory_order_relaxed);
+}
+
+DumpSampling dumpSampling() noexcept {
+  const std::uint64_t sampling {detail::dumpSampling.load(std::memory_order_relaxed)};
+  return DumpSampling {std::max<std::uint32_t>(static_cast<std::uint32_t>(sampling >> 32), 1),
+                       static_cast<std::uint32_t>(sampling)};
+}
+
 DUMP_CONTEXT_OPTION setFixedContextOption() {
-  dumpContextOption = DUMP_CONTEXT_OPTION::FixedContext;
-  return dumpContextOption;
+  return updateDefaultDumpOptions([](DumpOptions& o) {
+    o.contextOption = DUMP_CONTEXT_OPTION::FixedContext;
+  }).contextOption;
 }
 
 DUMP_CONTEXT_OPTION setDynamicContextOption() {
-  dumpContextOption = DUMP_CONTEXT_OPTION::DynamicContext;
-  return dumpContextOption;
+  return updateDefaultDumpOptions([](DumpOptions& o) {
+    o.contextOption = DUMP_CONTEXT_OPTION::DynamicContext;
+  }).contextOption;
 }
 
 uptr_t setFixedPreBufferSize(const uptr_t newSize) {
-  fixedPreBufferSize = newSize;
-  return fixedPreBufferSize;
+  return updateDefaultDumpOptions([newSize](DumpOptions& o) {
+    o.preBufferSize = newSize;
+  }).preBufferSize;
 }
 
 uptr_t setFixedPostBufferSize(const uptr_t newSize) {
-  fixedPostBufferSize = newSize;
-  return fixedPostBufferSize;
+  return updateDefaultDumpOptions([newSize](DumpOptions& o) {
+    o.postBufferSize = newSize;
+  }).postBufferSize;
+}
+
+bool setColorOption(const bool enabled) {
+  return updateDefaultDumpOptions([enabled](DumpOptions& o) {
+    o.color = enabled;
+  }).color;
+}
+
+bool setAutoColorOption(const bool enabled) {
+  return updateDefaultDumpOptions([enabled](DumpOptions& o) {
+    o.autoColor = enabled;
+  }).autoColor;
+}
+
+bool useColors(const DumpOptions& options, const Sink& sink) noexcept {
+  return options.color && (!options.autoColor || sink.terminal());
+}
+
+bool useColors(const DumpOptions& options, std::ostream& os) noexcept {
+  return useColors(options, OstreamSink {os});
 }
 
 void dumpMemory(const char a[], std::ostream& os) {
-  std::cout << "memDump::dumpMemory(char [],...) called before ...\n";
+  MEMDUMP_TRACE("memDump::dumpMemory(char [],...) called before ...\n");
   dumpMemory(a, std::strlen(a), os);
 }
 
-// See: https://jrruethe.github.io/blog/2015/08/23/placement-new/ for original code;
-// page not found on Feb 2025, it's been archived here last time:
-// https://web.archive.org/web/20210728162751/https://jrruethe.github.io/blog/2015/08/23/placement-new/
 void dumpMemory(const void* ptr,
                 const std::size_t size,
-                const std::string&& demangledTypeName,
+                const std::string_view demangledTypeName,
                 std::ostream& os) noexcept {
+  dumpMemory(ptr, size, currentDumpOptions(), demangledTypeName, os);
+}
+
+DumpWindow dumpWindow(const void* ptr,
+                      const std::size_t size,
+                      const DumpOptions& options) noexcept {
+  const uptr_t rowWidth {options.validRowWidth()};
+
   // Allow direct arithmetic on the pointer
-  uptr_t sptr {reinterpret_cast<uptr_t>(ptr)}; // Start pointer of data to dump
-  uptr_t eptr {sptr + size - 1};               // End pointer of data to dump
+  const uptr_t sptr {reinterpret_cast<uptr_t>(ptr)}; // Start pointer of data to dump
+  const uptr_t eptr {sptr + size - 1};               // End pointer of data to dump
 
   // set-up the context buffers around the data to dump
   uptr_t preBufferSize {};
   uptr_t postBufferSize {};
-  switch (dumpContextOption) {
+  switch (options.contextOption) {
     case DUMP_CONTEXT_OPTION::FixedContext:
     // Option Fixed: fixed context: dump from (sptr - preBufferSize) bytes through (eptr + postBufferSize) bytes
-    preBufferSize = fixedPreBufferSize;
-    postBufferSize = fixedPostBufferSize;
+    preBufferSize = options.preBufferSize;
+    postBufferSize = options.postBufferSize;
     break;
 
     case DUMP_CONTEXT_OPTION::DynamicContext:
     default:
     // Option Dynamic: dynamic context
-    uptr_t smemptr {sptr & ~15}; // Round down to the last multiple of 16
-    smemptr = smemptr - 16;      // Step back one line for context
-    uptr_t ememptr {eptr & ~15}; // Round down to the last multiple of 16
-    ememptr = ememptr + 31;      // Step forward one line for context
+    uptr_t smemptr {sptr - sptr % rowWidth};  // Round down to the last multiple of rowWidth
+    smemptr = smemptr - rowWidth;             // Step back one line for context
+    uptr_t ememptr {eptr - eptr % rowWidth};  // Round down to the last multiple of rowWidth
+    ememptr = ememptr + 2 * rowWidth - 1;     // Step forward one line for context
 /*
-    os << ">>>>> smemptr (hex): 0x" << std::hex << smemptr << std::dec
-       << " ememptr (hex): 0x" << std::hex << ememptr << std::dec
-       << " (ememptr - smemptr): " << (ememptr - smemptr)
-       << " preBufferSize = (sptr - smemptr): " << (sptr - smemptr)
-       << " postBufferSize = (ememptr - eptr): " << (ememptr - eptr)
-       << "\n";
+    std::cout << ">>>>> smemptr (hex): 0x" << std::hex << smemptr << std::dec
+              << " ememptr (hex): 0x" << std::hex << ememptr << std::dec
+              << " (ememptr - smemptr): " << (ememptr - smemptr)
+              << " preBufferSize = (sptr - smemptr): " << (sptr - smemptr)
+              << " postBufferSize = (ememptr - eptr): " << (ememptr - eptr)
+              << "\n";
 */
     preBufferSize = (sptr - smemptr);
     postBufferSize = (ememptr - eptr);
     break;
   }
 
-  sptr = sptr - preBufferSize;   // Start pointer - preBufferSize
-  eptr = eptr + postBufferSize;  // End pointer + postBufferSize
+  return DumpWindow {sptr, size, preBufferSize, postBufferSize};
+}
+
+DumpRenderer::DumpRenderer(const DumpWindow& window,
+                           const DumpOptions& options,
+                           const std::string_view demangledTypeName,
+                           std::ostream& os) noexcept :
+stream_(std::in_place, os),
+sink_(*stream_),
+window_(window),
+rowWidth_(options.validRowWidth()),
+groupSize_(options.validGroupSize()),
+red_(useColors(options, sink_) ? std::string_view {FGRED} : std::string_view {}),
+reset_(red_.empty() ? std::string_view {} : std::string_view {RESET_COLOR}),
+collapse_(options.collapseRepeatedRows),
+cacheLineSize_(options.cacheLineSize),
+state_ {window.start(), 0, false, false}
+{
+  begin(demangledTypeName);
+}
+
+DumpRenderer::DumpRenderer(const DumpWindow& window,
+                           const DumpOptions& options,
+                           const std::string_view demangledTypeName,
+                           Sink& sink) noexcept :
+sink_(sink),
+window_(window),
+rowWidth_(options.validRowWidth()),
+groupSize_(options.validGroupSize()),
+// highlighting colors, or nothing when colors are disabled or not shown
+red_(useColors(options, sink_) ? std::string_view {FGRED} : std::string_view {}),
+reset_(red_.empty() ? std::string_view {} : std::string_view {RESET_COLOR}),
+collapse_(options.collapseRepeatedRows),
+cacheLineSize_(options.cacheLineSize),
+state_ {window.start(), 0, false, false}  // Start pointer - preBufferSize
+{
+  begin(demangledTypeName);
+}
 
-  [[maybe_unused]] const auto memToDumpSize {eptr - sptr + 1};
-  const auto endByteToDump {(preBufferSize + size + postBufferSize)};
-  const auto endByteToMark {(preBufferSize + size - 1)};
+void DumpRenderer::begin(const std::string_view demangledTypeName) noexcept {
 /*
-  os << ">>>>> sptr (hex): 0x" << std::hex << sptr << std::dec
-     << " eptr (hex): 0x" << std::hex << eptr << std::dec
-     << " preBufferSize: " << preBufferSize
-     << " postBufferSize: " << postBufferSize
-     << " memToDumpSize: " << memToDumpSize
-     << " size: " << size
-     << " endByteToMark: " << endByteToMark
-     << " endByteToDump: " << endByteToDump << "\n";
+  std::cout << ">>>>> sptr (hex): 0x" << std::hex << state_.sptr << std::dec
+            << " preBufferSize: " << window_.preBufferSize
+            << " postBufferSize: " << window_.postBufferSize
+            << " size: " << window_.size
+            << " endByteToMark: " << (window_.preBufferSize + window_.size - 1)
+            << " endByteToDump: " << window_.length() << "\n";
 */
-  os << "[memDump:dumpMemory]---------------------------------------------------\n";
-  if ("" != demangledTypeName) {
-    os << "Type "
-       << demangledTypeName
-       << " of "
-       << std::dec
-       << size
-       << " bytes - Memory to dump starts at: "
-       << std::hex << std::uppercase
-       << ptr
-       << "\n\n";
-  } else {
-    os << size
-       << " bytes - Memory to dump starts at: "
-       << std::hex << std::uppercase
-       << ptr
-       << "\n\n";
+  RowFormatter row {sink_};
+
+  row.append("[memDump:dumpMemory]---------------------------------------------------\n");
+  if (!demangledTypeName.empty()) {
+    // the name may not fit in the row buffer
+    row.append("Type ");
+    row.flush();
+    sink_.write(demangledTypeName);
+    row.append(" of ");
+  }
+  row.appendDecimal(window_.size);
+  row.append(" bytes - Memory to dump starts at: ");
+  row.appendPointer(window_.address);
+  row.append('\n');
+  if (cacheLineSize_ > 0) {
+    const uptr_t lines {(0 == window_.size) ? 0
+                                            : (window_.address + window_.size - 1) / cacheLineSize_ - window_.address / cacheLineSize_ + 1};
+    row.append("Spans ");
+    row.appendDecimal(lines);
+    row.append((1 == lines) ? " cache line of " : " cache lines of ");
+    row.appendDecimal(cacheLineSize_);
+    row.append(" bytes\n");
   }
+  row.append('\n');
 
   // Print the address offsets along the top row
-  os << std::string(19, ' ');
-  for (uptr_t i {0}; i < 16; ++i) {
-    // Spaces between every 4 bytes
-    if (i % 4 == 0) {
-      os << " ";
-    }
-    os << std::hex
-       << std::uppercase
-       << " "
-       << std::setfill(' ')
-       << std::setw(2)
-       << i;
-  }
+  row.appendRuler(rowWidth_, groupSize_);
 
   // If the object is not aligned
-  if (sptr % 16 != 0) {
+  if (state_.sptr % rowWidth_ != 0) {
     // Print the first address
-    os << "\n0x"
-       << std::setfill('0')
-       << std::setw(16)
-       << (sptr & ~15)
-       << std::setw(0)
-       << ":";
+    row.appendCacheLine(state_.sptr - state_.sptr % rowWidth_, rowWidth_, cacheLineSize_);
+    row.appendAddress(state_.sptr - state_.sptr % rowWidth_);
 
     // Indent to the offset
-    for (uptr_t i {0}; i < sptr % 16; ++i) {
-      os << "   ";
-      if (i % 4 == 0) {
-        os << " ";
+    for (uptr_t i {0}; i < state_.sptr % rowWidth_; ++i) {
+      row.append("   ");
+      if (i % groupSize_ == 0) {
+        row.append(' ');
       }
     }
   }
+}
 
-  bool closed {false};
-  bool marking {false};
+DumpRenderer::~DumpRenderer() {
+  finish();
+}
+
+DumpRenderer::State DumpRenderer::stateAt(const uptr_t index) const noexcept {
+  // the highlighting markers are printed around the bytes preBufferSize
+  // through endByteToMark
+  const uptr_t preBufferSize {window_.preBufferSize};
+  const uptr_t endByteToMark {(preBufferSize + window_.size - 1)};
+
+  return State {window_.start() + index,
+                index,
+                (index > 0) && (index - 1 == endByteToMark),
+                (preBufferSize < index) && (index <= endByteToMark)};
+}
+
+bool DumpRenderer::collapsible(const uptr_t index) const noexcept {
+  // the rows with the markers or highlighted bytes are always printed
+  const uptr_t preBufferSize {window_.preBufferSize};
+  const uptr_t endByteToMark {std::max(preBufferSize + window_.size, preBufferSize + 1) - 1};
+
+  return (index + rowWidth_ <= preBufferSize) || (index > endByteToMark);
+}
+
+void DumpRenderer::render(const byte_t* bytes, const uptr_t count) noexcept {
+  renderBytes(sink_, state_, bytes, std::min(state_.index + count, window_.length()));
+}
+
+void DumpRenderer::renderUnreadable(const uptr_t count) noexcept {
+  renderBytes(sink_, state_, nullptr, std::min(state_.index + count, window_.length()));
+}
+
+void DumpRenderer::renderMemory(const bool safeRead) noexcept {
+  const uptr_t end {window_.start() + window_.length()};
+  if (!safeRead) {
+    render(reinterpret_cast<const byte_t*>(state_.sptr), end - state_.sptr);
+    return;
+  }
+
+  // the memory is copied a page at a time by a system call, which fails on
+  // the pages not readable, whatever the mappings were when last read; and
+  // allocates nothing
+  static const auto page {static_cast<uptr_t>(::sysconf(_SC_PAGESIZE))};
+  byte_t buffer[4096];
+  while (state_.sptr < end) {
+    const uptr_t count {std::min({end - state_.sptr, (state_.sptr / page + 1) * page - state_.sptr, uptr_t {sizeof(buffer)}})};
+    const std::size_t copied {copyMemory(state_.sptr, count, buffer)};
+    render(buffer, copied);
+    renderUnreadable(count - copied);
+  }
+}
+
+void DumpRenderer::renderChunk(Sink& sink,
+                               const byte_t* bytes,
+                               const uptr_t begin,
+                               const uptr_t end) const noexcept {
+  State state {stateAt(begin)};
+
+  if (collapse_ && (nullptr != bytes) && (begin >= rowWidth_)) {
+    // the row before the chunk, and whether it was collapsed, as if the
+    // window were rendered in one go
+    const uptr_t previous {begin - rowWidth_};
+    std::memcpy(state.previous, bytes - rowWidth_, rowWidth_);
+    state.previousValid = true;
+    state.collapsing = (previous >= rowWidth_) && collapsible(previous) &&
+                       (0 == std::memcmp(bytes - rowWidth_, bytes - 2 * rowWidth_, rowWidth_));
+  }
+  renderBytes(sink, state, bytes, std::min(end, window_.length()));
+}
+
+void DumpRenderer::skip(const uptr_t count) noexcept {
+  state_ = stateAt(std::min(state_.index + count, window_.length()));
+}
+
+void DumpRenderer::renderBytes(Sink& sink,
+                               State& state,
+                               const byte_t* bytes,
+                               const uptr_t endByteToDump) const noexcept {
+  const uptr_t preBufferSize {window_.preBufferSize};
+  const uptr_t endByteToMark {(preBufferSize + window_.size - 1)};
+  uptr_t sptr {state.sptr};
+  bool closed {state.closed};
+  bool marking {state.marking};
+  // the last full row rendered; none if a row is split between two calls
+  const byte_t* previousRow {(state.previousValid && (sptr % rowWidth_ == 0)) ? state.previous : nullptr};
+  bool collapsing {state.collapsing};
+
+  RowFormatter row {sink};
+  // each row ends in the default color
+  RowColor color {row, reset_};
 
   // Dump the memory
-  for (uptr_t i {0}; i < endByteToDump; ++i, ++sptr) {
-    // New line and address every 16 bytes, spaces every 4 bytes
-    if (sptr % 16 == 0) {
-      os << "\n0x"
-         << std::setfill('0')
-         << std::setw(16)
-         << sptr
-         << std::setw(0)
-         << ":";
+  for (uptr_t i {state.index}; i < endByteToDump; ++i, ++sptr) {
+    // New line and address every row, spaces every group of bytes
+    if (sptr % rowWidth_ == 0) {
+      const bool fullRow {(nullptr != bytes) && (i + rowWidth_ <= endByteToDump)};
+      if (collapse_ && fullRow && (nullptr != previousRow) && collapsible(i) &&
+          (0 == std::memcmp(bytes, previousRow, rowWidth_))) {
+        // the run of rows equal to the previous one, up to the highlighted
+        // rows: compare the bytes with those one row before, vectorized
+        const uptr_t limit {(i < preBufferSize) ? std::min(endByteToDump, preBufferSize) : endByteToDump};
+        const uptr_t rows {(limit - i) / rowWidth_};
+        const uptr_t equal {rowWidth_ + simd::firstDifference(bytes + rowWidth_, bytes, (rows - 1) * rowWidth_)};
+        const uptr_t collapsed {equal - equal % rowWidth_};
+        if (!collapsing) {
+          color.set({});
+          row.flush();
+          row.append("\n*");
+          collapsing = true;
+        }
+        bytes += collapsed;
+        previousRow = bytes - rowWidth_;
+        closed = false;
+        // the loop steps to the byte after the collapsed rows
+        i += collapsed - 1;
+        sptr += collapsed - 1;
+        continue;
+      }
+      previousRow = fullRow ? bytes : nullptr;
+      collapsing = false;
+      color.set({});
+      row.flush();
+      row.appendCacheLine(sptr, rowWidth_, cacheLineSize_);
+      row.appendAddress(sptr);
     }
-    if (sptr % 4 == 0) {
-      os << " ";
+    if (sptr % groupSize_ == 0) {
+      row.append(' ');
     }
 
     // Print the address contents
     if (preBufferSize == i) {
-      os << FGRED << "<";  // start highlighting marker
+      color.set(red_);
+      row.append('<');  // start highlighting marker
       marking = true;
     } else {
       if (closed) {
         closed = false;
-        if (sptr % 16 == 0) {
-          os << " ";
+        if (sptr % rowWidth_ == 0) {
+          row.append(' ');
         }
       } else {
-        os << " ";
+        row.append(' ');
       }
     }
-    os << ((marking) ? FGRED : "")
-       << std::hex
-       << std::setw(2)
-       << std::setfill('0')
-       << static_cast<uptr_t>(*reinterpret_cast<byte_t *>(sptr))
-       << RESET_COLOR;
+    if (marking) {
+      color.set(red_);
+    }
+    if (nullptr != bytes) {
+      row.appendByte(*bytes++);
+    } else {
+      row.append("??");  // unreadable
+    }
     if (endByteToMark == i) {
       closed = true;
       marking = false;
-      os << FGRED << ">" << RESET_COLOR;  // end highlighting marker
+      row.append('>');  // end highlighting marker
+      color.set({});
     }
   }
-  os << "\n-----------------------------------------------------------------------\n";
+  color.set({});
+  const bool previousValid {(nullptr != previousRow) && (sptr % rowWidth_ == 0)};
+  if (previousValid && (previousRow != state.previous)) {
+    std::memcpy(state.previous, previousRow, rowWidth_);
+  }
+  state.sptr = sptr;
+  state.index = std::max(state.index, endByteToDump);
+  state.closed = closed;
+  state.marking = marking;
+  state.previousValid = previousValid;
+  state.collapsing = collapsing;
+}
+
+void DumpRenderer::finish() noexcept {
+  if (finished_) {
+    return;
+  }
+  finished_ = true;
+  sink_.write("\n-----------------------------------------------------------------------\n");
+  sink_.flush();
+  if (stream_) {
+    // the iostream formatter used to leave the stream in hex, upper case,
+    // '0'-filled mode; callers (see main.cpp) rely on that, so keep it
+    stream_->stream() << std::hex << std::uppercase << std::setfill('0');
+  }
+}
+
+HighlightRowRenderer::HighlightRowRenderer(const DumpOptions& options, std::ostream& os) noexcept :
+stream_(std::in_place, os),
+sink_(*stream_),
+rowWidth_(options.validRowWidth()),
+groupSize_(options.validGroupSize()),
+red_(useColors(options, sink_) ? std::string_view {FGRED} : std::string_view {}),
+reset_(red_.empty() ? std::string_view {} : std::string_view {RESET_COLOR})
+{}
+
+HighlightRowRenderer::HighlightRowRenderer(const DumpOptions& options, Sink& sink) noexcept :
+sink_(sink),
+rowWidth_(options.validRowWidth()),
+groupSize_(options.validGroupSize()),
+red_(useColors(options, sink_) ? std::string_view {FGRED} : std::string_view {}),
+reset_(red_.empty() ? std::string_view {} : std::string_view {RESET_COLOR})
+{}
+
+void HighlightRowRenderer::ruler() noexcept {
+  RowFormatter row {sink_};
+
+  row.appendRuler(rowWidth_, groupSize_);
+}
+
+void HighlightRowRenderer::row(const uptr_t address,
+                               const byte_t* bytes,
+                               const uptr_t first,
+                               const uptr_t count,
+                               const std::uint64_t highlighted) noexcept {
+  const uptr_t last {std::min(first + count, rowWidth_)};
+  auto isHighlighted = [highlighted, last](const uptr_t column) {
+    return (column < last) && (0 != ((highlighted >> column) & 1));
+  };
+  bool marking {false};
+  bool closed {false};
+
+  RowFormatter row {sink_};
+  RowColor color {row, reset_};
+
+  row.appendAddress(address);
+  // Indent to the first byte
+  for (uptr_t i {0}; i < first; ++i) {
+    row.append("   ");
+    if (i % groupSize_ == 0) {
+      row.append(' ');
+    }
+  }
+
+  for (uptr_t i {first}; i < last; ++i) {
+    if (i % groupSize_ == 0) {
+      row.append(' ');
+    }
+    if (isHighlighted(i) && !marking) {
+      color.set(red_);
+      row.append('<');  // start highlighting marker
+      marking = true;
+    } else if (closed) {
+      closed = false;
+    } else {
+      row.append(' ');
+    }
+    if (nullptr != bytes) {
+      row.appendByte(*bytes++);
+    } else {
+      row.append("??");  // unreadable
+    }
+    // the runs are closed at the end of the row
+    if (marking && !isHighlighted(i + 1)) {
+      closed = true;
+      marking = false;
+      row.append('>');  // end highlighting marker
+      color.set({});
+    }
+  }
+  color.set({});
+}
+
+void HighlightRowRenderer::styledRow(const uptr_t address,
+                                     const byte_t* bytes,
+                                     const uptr_t first,
+                                     const uptr_t count,
+                                     const std::string_view* colors,
+                                     const char* markers) noexcept {
+  const uptr_t last {std::min(first + count, rowWidth_)};
+  bool closed {false};
+
+  RowFormatter row {sink_};
+  RowColor color {row, reset_};
+
+  row.appendAddress(address);
+  // Indent to the first byte
+  for (uptr_t i {0}; i < first; ++i) {
+    row.append("   ");
+    if (i % groupSize_ == 0) {
+      row.append(' ');
+    }
+  }
+
+  for (uptr_t i {first}; i < last; ++i) {
+    if (i % groupSize_ == 0) {
+      row.append(' ');
+    }
+    // the markers in the default color
+    if ((' ' != markers[i]) && ('>' != markers[i])) {
+      color.set({});
+      row.append(markers[i]);
+    } else if (closed) {
+      closed = false;
+    } else {
+      row.append(' ');
+    }
+    // no colors when they aren't shown
+    color.set(reset_.empty() ? std::string_view {} : colors[i]);
+    if (nullptr != bytes) {
+      row.appendByte(*bytes++);
+    } else {
+      row.append("??");  // unreadable
+    }
+    if ('>' == markers[i + 1]) {
+      closed = true;
+      color.set({});
+      row.append('>');
+    }
+  }
+  color.set({});
+}
+
+void HighlightRowRenderer::skipped() noexcept {
+  sink_.write("\n*", 2);
+}
+
+void renderDump(const DumpWindow& window,
+                const byte_t* bytes,
+                const DumpOptions& options,
+                const std::string_view demangledTypeName,
+                std::ostream& os) noexcept {
+  DumpRenderer renderer {window, options, demangledTypeName, os};
+
+  renderer.render(bytes, window.length());
+}  // renderDump
+
+void renderDump(const DumpWindow& window,
+                const byte_t* bytes,
+                const DumpOptions& options,
+                const std::string_view demangledTypeName,
+                Sink& sink) noexcept {
+  DumpRenderer renderer {window, options, demangledTypeName, sink};
+
+  renderer.render(bytes, window.length());
+}  // renderDump
+
+// See: https://jrruethe.github.io/blog/2015/08/23/placement-new/ for original code;
+// page not found on Feb 2025, it's been archived here last time:
+// https://web.archive.org/web/20210728162751/https://jrruethe.github.io/blog/2015/08/23/placement-new/
+void dumpMemory(const void* ptr,
+                const std::size_t size,
+                const DumpOptions& options,
+                const std::string_view demangledTypeName,
+                std::ostream& os) noexcept {
+  DumpRenderer renderer {dumpWindow(ptr, size, options), options, demangledTypeName, os};
+
+  renderer.renderMemory(options.safeRead);
+}  // dumpMemory
+
+void dumpMemory(const void* ptr,
+                const std::size_t size,
+                const DumpOptions& options,
+                const std::string_view demangledTypeName,
+                Sink& sink) noexcept {
+  DumpRenderer renderer {dumpWindow(ptr, size, options), options, demangledTypeName, sink};
+
+  renderer.renderMemory(options.safeRead);
 }  // dumpMemory
 }  // namespace memDump
+
+namespace demangle {
+std::string demangledName(const char* mangledName) {
+  int status {};
+  char* demangled {abi::__cxa_demangle(mangledName, nullptr, nullptr, &status)};
+  if ((0 != status) || (nullptr == demangled)) {
+    std::free(demangled);
+    return mangledName;
+  }
+  const std::string name {demangled};
+
+  std::free(demangled);
+  return name;
+}
+}  // namespace demangle
@@ -3,33 +3,122 @@
 //
 #pragma once
 
+#include "memDumpSink.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <type_traits>
-#include <cxxabi.h>
+#include <typeinfo>
+#include <cstdint>
 #include <cstring>
 ////////////////////////////////////////////////////////////////////////////////
-// useful macros
+// useful macros. MEMDUMP_LEVEL 0 compiles them out, their arguments not
+// evaluated; otherwise each call site dumps as setDumpSampling() says. With
+// MEMDUMP_CALLSITE_STATS each call site keeps statistics, see memDumpCallSites.h
+#if !defined(MEMDUMP_LEVEL)
+#define MEMDUMP_LEVEL 1
+#endif
+
+#if defined(MEMDUMP_CALLSITE_STATS)
+#define MEMDUMP_DUMP_VAR(var) memDump::dumpMemoryAt(MEMDUMP_CALL_SITE, &(var), sizeof(decltype(var)))
+#define MEMDUMP_DUMP_PTR(ptr, type) memDump::dumpMemoryAt(MEMDUMP_CALL_SITE, ptr, sizeof(type))
+#else
+#define MEMDUMP_DUMP_VAR(var) memDump::dumpMemory(&(var), sizeof(decltype(var)))
+#define MEMDUMP_DUMP_PTR(ptr, type) memDump::dumpMemory(ptr, sizeof(type))
+#endif
+
+// the sampling gate of the expansion of a macro, a static of its own lambda
+#define MEMDUMP_SAMPLED(dump)                                                      \
+  (memDump::sampleCallSite([]() -> memDump::CallSiteGate& {                        \
+     static memDump::CallSiteGate gate {};                                         \
+     return gate;                                                                  \
+   }()) ? (void) (dump) : (void) 0)
+
+#if MEMDUMP_LEVEL > 0
 // in case we want to dump a variable
-#define DMV(var) memDump::dumpMemory(&(var), sizeof(decltype(var)))
-//#define DMV(var) memDump::dumpMemory(&(var), sizeof(decltype(var)), getDemangledTypeName<decltype(var)>())
+#define DMV(var) MEMDUMP_SAMPLED(MEMDUMP_DUMP_VAR(var))
 // in case we want to dump a memory of type type, pointed to by a pointer ptr
-#define DMP(ptr, type) memDump::dumpMemory(ptr, sizeof(type))
-//#define DMP(ptr, type) memDump::dumpMemory(ptr, sizeof(type), getDemangledTypeName<type>())
+#define DMP(ptr, type) MEMDUMP_SAMPLED(MEMDUMP_DUMP_PTR(ptr, type))
+#else
+#define DMV(var) ((void) sizeof(var))
+#define DMP(ptr, type) ((void) sizeof(ptr), (void) sizeof(type))
+#endif
+
+// the calls of the dumpMemory() overloads, printed with MEMDUMP_TRACE_CALLS
+#if defined(MEMDUMP_TRACE_CALLS)
+#define MEMDUMP_TRACE(message) (std::cout << (message))
+#else
+#define MEMDUMP_TRACE(message) ((void) 0)
+#endif
 
 namespace demangle {
-template<typename T>
-static std::string getDemangledTypeName() noexcept;
+// the demangled name of a typeid() name; the name itself if it can't be
+// demangled. Allocates: see typeName() for the names of types known at
+// compile time
+std::string demangledName(const char* mangledName);
 
-template<typename T>
-static std::string getDemangledTypeName() noexcept {
-  int status {};
-  char *demangledName {abi::__cxa_demangle(typeid(T).name(), nullptr, nullptr, &status)};
-  const std::string demangledNameString {static_cast<std::string>(demangledName)};
+namespace detail {
+// the type in the signature of the function, e.g. GCC
+//   const char* demangle::detail::signature() [with T = test_t]
+// and clang
+//   const char* demangle::detail::signature() [T = test_t]
+// A plain return type keeps GCC from listing typedefs after the type
+template <typename T>
+constexpr const char* signature() noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return __PRETTY_FUNCTION__;
+#else
+  return "";
+#endif
+}
+
+template <typename T>
+constexpr std::string_view prettyTypeName() noexcept {
+  const std::string_view function {signature<T>()};
+  const std::size_t begin {function.find("T = ")};
+  const std::size_t end {function.rfind(']')};
+  if ((std::string_view::npos == begin) || (std::string_view::npos == end) || (end < begin + 4)) {
+    return {};
+  }
+  return function.substr(begin + 4, end - begin - 4);
+}
 
-  free(demangledName);
+// the name copied out of the signature at compile time, so that only the
+// name is kept in the binary
+template <typename T>
+struct TypeNameStorage {
+  static constexpr std::size_t size {prettyTypeName<T>().size()};
+  static constexpr auto name {[] {
+    std::array<char, size + 1> name {};
+    const std::string_view pretty {prettyTypeName<T>()};
+    for (std::size_t i {0}; i < size; ++i) {
+      name[i] = pretty[i];
+    }
+    return name;
+  }()};
+};
+}  // namespace detail
+
+// The name of T without allocations: computed at compile time from the
+// signature of a function template, or else demangled once per type
+template <typename T>
+std::string_view typeName() noexcept {
+  using storage = detail::TypeNameStorage<T>;
+  if constexpr (storage::size > 0) {
+    return std::string_view {storage::name.data(), storage::size};
+  } else {
+    static const std::string name {demangledName(typeid(T).name())};
+    return name;
+  }
+}
 
-  return demangledNameString;
+template<typename T>
+std::string getDemangledTypeName() noexcept {
+  return std::string {typeName<T>()};
 }
 }  // namespace demangle
 
@@ -46,35 +135,346 @@ enum class DUMP_CONTEXT_OPTION {
 extern const std::string FGRED;    // foreground red
 extern const std::string FGGREEN;  // foreground green
 extern const std::string RESET_COLOR;
+// colors telling apart the ranges of the dumps that highlight more than one
+constexpr std::size_t RANGE_COLOR_COUNT {6};
+extern const std::string_view RANGE_COLORS[RANGE_COLOR_COUNT];
+
+// Options of a dump; an immutable value, passed per call or installed per
+// thread, so that threads dumping concurrently never share mutable state
+struct DumpOptions {
+  DUMP_CONTEXT_OPTION contextOption {DUMP_CONTEXT_OPTION::DynamicContext};
+  uptr_t preBufferSize {24};   // bytes dumped before the data with FixedContext
+  uptr_t postBufferSize {24};  // bytes dumped after the data with FixedContext
+  bool color {true};           // highlighting colors; the <...> markers are always printed
+  bool autoColor {true};       // colors only when the sink is a terminal, see Sink::terminal()
+  uptr_t rowWidth {16};        // bytes per row, 1 through maxRowWidth
+  uptr_t groupSize {4};        // bytes between the extra spaces in a row
+  bool safeRead {true};        // read only the readable pages, printing the others as ??
+  bool collapseRepeatedRows {false};  // print the rows equal to the one before as a single *
+  uptr_t cacheLineSize {0};    // draw the boundaries of cache lines of this size; 0: none
+
+  static constexpr uptr_t maxRowWidth {64};
+
+  // rowWidth and groupSize brought to their valid ranges
+  uptr_t validRowWidth() const noexcept {
+    return std::clamp<uptr_t>(rowWidth, 1, maxRowWidth);
+  }
+
+  uptr_t validGroupSize() const noexcept {
+    return std::max<uptr_t>(groupSize, 1);
+  }
+
+  bool operator==(const DumpOptions&) const noexcept = default;
+};
 
 void checkEndianness();
 
+// The options used by the dumps that don't pass their own: the ones installed
+// for the calling thread if any, otherwise the process-wide defaults.
+// Lock-free: a thread-local read, or an atomic load of an immutable snapshot
+const DumpOptions& currentDumpOptions() noexcept;
+
+// Install options for the calling thread only; return the options replaced
+DumpOptions setThreadDumpOptions(const DumpOptions& options) noexcept;
+// Go back to the process-wide defaults in the calling thread
+void clearThreadDumpOptions() noexcept;
+
+// Install options for the calling thread for the lifetime of the object
+class ScopedDumpOptions final {
+public:
+  explicit ScopedDumpOptions(const DumpOptions& options) noexcept;
+  ~ScopedDumpOptions();
+
+  ScopedDumpOptions(const ScopedDumpOptions&) = delete;
+  ScopedDumpOptions& operator=(const ScopedDumpOptions&) = delete;
+
+private:
+  bool hadThreadOptions_;
+  DumpOptions previous_;
+};
+
+// The process-wide defaults: each setter publishes a new immutable snapshot
+void setDefaultDumpOptions(const DumpOptions& options);
+DumpOptions getDefaultDumpOptions() noexcept;
+
+// Sampling of the dumps of the DMV() and DMP() macros, per call site: one in
+// everyN calls, then at most maxPerSecond a second (0: no limit). By default
+// every call dumps
+struct DumpSampling {
+  std::uint32_t everyN {1};
+  std::uint32_t maxPerSecond {0};
+};
+
+void setDumpSampling(const DumpSampling& sampling) noexcept;
+DumpSampling dumpSampling() noexcept;
+
+// The sampling state of a call site of the macros. Its counters are relaxed
+// atomics, read and written without read-modify-writes: calls racing on
+// other threads may dump a little more often than sampled
+struct CallSiteGate {
+  std::atomic<std::uint32_t> skip {0};   // calls to skip before the next dump
+  std::atomic<std::int64_t> second {0};  // of the dumps counted
+  std::atomic<std::uint32_t> dumps {0};  // in second
+};
+
+namespace detail {
+// everyN in the high half, maxPerSecond in the low one; 0: no sampling
+extern std::atomic<std::uint64_t> dumpSampling;
+bool sampleCallSite(CallSiteGate& gate, const std::uint64_t sampling) noexcept;
+}  // namespace detail
+
+// The call at gate dumps. A call skipped by everyN costs two relaxed loads,
+// a store and a branch; the other calls check the rate out of line
+inline bool sampleCallSite(CallSiteGate& gate) noexcept {
+  const std::uint64_t sampling {detail::dumpSampling.load(std::memory_order_relaxed)};
+  if (0 == sampling) {
+    return true;
+  }
+  const std::uint32_t skip {gate.skip.load(std::memory_order_relaxed)};
+  if (skip > 0) {
+    gate.skip.store(skip - 1, std::memory_order_relaxed);
+    return false;
+  }
+  return detail::sampleCallSite(gate, sampling);
+}
+
 DUMP_CONTEXT_OPTION setFixedContextOption();
 DUMP_CONTEXT_OPTION setDynamicContextOption();
 
-uptr_t setFixedPreBufferSize();
-uptr_t setFixedPostBufferSize();
+uptr_t setFixedPreBufferSize(const uptr_t newSize);
+uptr_t setFixedPostBufferSize(const uptr_t newSize);
+
+// enable/disable the highlighting colors; the <...> markers are always printed
+bool setColorOption(const bool enabled);
+// enable/disable the colors only on terminals
+bool setAutoColorOption(const bool enabled);
+
+// the dumps with options to sink, or to os, are in colors
+bool useColors(const DumpOptions& options, const Sink& sink) noexcept;
+bool useColors(const DumpOptions& options, std::ostream& os) noexcept;
+
+// The memory a dump shows: size bytes at address, with the context buffers
+// of preBufferSize bytes before and postBufferSize bytes after
+struct DumpWindow {
+  uptr_t address;
+  uptr_t size;
+  uptr_t preBufferSize;
+  uptr_t postBufferSize;
+
+  uptr_t start() const noexcept {
+    return address - preBufferSize;
+  }
+
+  uptr_t length() const noexcept {
+    return preBufferSize + size + postBufferSize;
+  }
+};
+
+// The window dumped for size bytes at ptr with the context of options
+DumpWindow dumpWindow(const void* ptr,
+                      const std::size_t size,
+                      const DumpOptions& options) noexcept;
+
+// Renders the dump of a window incrementally: the bytes of the window are
+// passed in order, in as many pieces as wanted (e.g. while mapping a file).
+// Each row is written to the sink with a single call
+class DumpRenderer final {
+public:
+  // print the header, the ruler and the indentation of the first row
+  DumpRenderer(const DumpWindow& window,
+               const DumpOptions& options,
+               const std::string_view demangledTypeName,
+               Sink& sink) noexcept;
+  DumpRenderer(const DumpWindow& window,
+               const DumpOptions& options,
+               const std::string_view demangledTypeName,
+               std::ostream& os) noexcept;
+  // finish() if not done yet
+  ~DumpRenderer();
+
+  DumpRenderer(const DumpRenderer&) = delete;
+  DumpRenderer& operator=(const DumpRenderer&) = delete;
+
+  // render the next count bytes of the window
+  void render(const byte_t* bytes, const uptr_t count) noexcept;
+  // render the next count bytes of the window as unreadable: ??
+  void renderUnreadable(const uptr_t count) noexcept;
+  // Render the rest of the window reading the memory at the addresses shown;
+  // with safeRead the memory is copied with copyMemory() (memDumpMaps.h), and
+  // the pages that can't be read are rendered as unreadable
+  void renderMemory(const bool safeRead) noexcept;
+  // print the closing line, and flush the sink
+  void finish() noexcept;
+
+  Sink& sink() noexcept {
+    return sink_;
+  }
+
+  // Render the bytes begin through end - 1 of the window to sink, without
+  // changing the renderer: chunks of a window can be rendered concurrently,
+  // then printed in order. begin must be the index of the first byte of a
+  // row, and window.size must not be 0; bytes nullptr: the bytes are
+  // unreadable. skip() then moves the renderer past the bytes rendered this way
+  void renderChunk(Sink& sink,
+                   const byte_t* bytes,
+                   const uptr_t begin,
+                   const uptr_t end) const noexcept;
+  void skip(const uptr_t count) noexcept;
+
+private:
+  struct State {
+    uptr_t sptr;   // address of the next byte to render
+    uptr_t index;  // index in the window of the next byte to render
+    bool closed;   // the closing marker was printed just before the next byte
+    bool marking;  // the next byte is highlighted
+    // the last full row rendered, when its bytes are known: the next row is
+    // collapsed if equal to it
+    bool previousValid {false};
+    bool collapsing {false};  // the * of the rows being collapsed was printed
+    byte_t previous[DumpOptions::maxRowWidth] {};
+  };
+
+  // the state before rendering the byte at index
+  State stateAt(const uptr_t index) const noexcept;
+  // the row at index isn't highlighted, and can be collapsed
+  bool collapsible(const uptr_t index) const noexcept;
+  // print the header, the ruler and the indentation of the first row
+  void begin(const std::string_view demangledTypeName) noexcept;
+  // bytes nullptr: the bytes are unreadable
+  void renderBytes(Sink& sink,
+                   State& state,
+                   const byte_t* bytes,
+                   const uptr_t endByteToDump) const noexcept;
+
+  std::optional<OstreamSink> stream_;  // when built on a std::ostream
+  Sink& sink_;
+  const DumpWindow window_;
+  const uptr_t rowWidth_;
+  const uptr_t groupSize_;
+  const std::string_view red_;
+  const std::string_view reset_;
+  const bool collapse_;
+  const uptr_t cacheLineSize_;
+  State state_;
+  bool finished_ {false};
+};
+
+// Renders rows of a dump with any set of highlighted bytes, for the dumps
+// that highlight more than one range: each run of highlighted bytes of a row
+// is printed like the data of dumpMemory(), between < and >
+class HighlightRowRenderer final {
+public:
+  HighlightRowRenderer(const DumpOptions& options, Sink& sink) noexcept;
+  HighlightRowRenderer(const DumpOptions& options, std::ostream& os) noexcept;
+
+  HighlightRowRenderer(const HighlightRowRenderer&) = delete;
+  HighlightRowRenderer& operator=(const HighlightRowRenderer&) = delete;
+
+  // print the address offsets along the top row
+  void ruler() noexcept;
+  // Print the row at address, a multiple of the row width, with the count
+  // bytes starting at column first; bit i of highlighted set highlights the
+  // byte at column i. bytes nullptr: the bytes are unreadable
+  void row(const uptr_t address,
+           const byte_t* bytes,
+           const uptr_t first,
+           const uptr_t count,
+           const std::uint64_t highlighted) noexcept;
+  // Print the row like row(), each byte in its own color: colors[i] is the
+  // color of the byte at column i, empty for none. markers[i], when not a
+  // space, is printed before the byte at column i in place of the space
+  // between bytes; a '>' is printed right after the byte before it, as the
+  // closing marker of dumpMemory(). markers has rowWidth() + 1 entries
+  void styledRow(const uptr_t address,
+                 const byte_t* bytes,
+                 const uptr_t first,
+                 const uptr_t count,
+                 const std::string_view* colors,
+                 const char* markers) noexcept;
+  // print the line standing for rows not printed
+  void skipped() noexcept;
+
+  uptr_t rowWidth() const noexcept {
+    return rowWidth_;
+  }
+
+private:
+  std::optional<OstreamSink> stream_;  // when built on a std::ostream
+  Sink& sink_;
+  const uptr_t rowWidth_;
+  const uptr_t groupSize_;
+  const std::string_view red_;
+  const std::string_view reset_;
+};
+
+// Render the dump of window, reading its window.length() bytes from bytes
+// instead of from the addresses shown: the bytes may be a copy of the memory
+// taken earlier, or somewhere else
+void renderDump(const DumpWindow& window,
+                const byte_t* bytes,
+                const DumpOptions& options,
+                const std::string_view demangledTypeName,
+                std::ostream& os) noexcept;
+
+void renderDump(const DumpWindow& window,
+                const byte_t* bytes,
+                const DumpOptions& options,
+                const std::string_view demangledTypeName,
+                Sink& sink) noexcept;
 
 void dumpMemory(const void* ptr,
                 const std::size_t size,
-                const std::string&& demangledTypeName = "",
+                const DumpOptions& options,
+                const std::string_view demangledTypeName = {},
+                std::ostream& os = std::cout) noexcept;
+
+// Dump to any sink: with a BufferSink or an FdSink nothing is allocated
+void dumpMemory(const void* ptr,
+                const std::size_t size,
+                const DumpOptions& options,
+                const std::string_view demangledTypeName,
+                Sink& sink) noexcept;
+
+void dumpMemory(const void* ptr,
+                const std::size_t size,
+                const std::string_view demangledTypeName = {},
                 std::ostream& os = std::cout) noexcept;
 
 template <typename T>
 void dumpMemory(const T ptr,
                 const std::size_t size,
+                const DumpOptions& options,
                 std::ostream& os = std::cout) noexcept;
 
 template <typename T>
 void dumpMemory(const T ptr,
                 const std::size_t size,
+                const DumpOptions& options,
                 std::ostream& os) noexcept {
-  std::cout << "memDump::dumpMemory(T ptr,...) called before ...\n";
   static_assert(std::is_pointer<T>::value, "pointer needed as arg 1 for dumpMemory()");
 
   dumpMemory(reinterpret_cast<const void*>(ptr),
              size,
-             demangle::getDemangledTypeName<decltype(typename std::remove_pointer<T>::type())>(),
+             options,
+             demangle::typeName<std::remove_cv_t<std::remove_pointer_t<T>>>(),
+             os);
+}
+
+template <typename T>
+void dumpMemory(const T ptr,
+                const std::size_t size,
+                std::ostream& os = std::cout) noexcept;
+
+template <typename T>
+void dumpMemory(const T ptr,
+                const std::size_t size,
+                std::ostream& os) noexcept {
+  MEMDUMP_TRACE("memDump::dumpMemory(T ptr,...) called before ...\n");
+  static_assert(std::is_pointer<T>::value, "pointer needed as arg 1 for dumpMemory()");
+
+  dumpMemory(reinterpret_cast<const void*>(ptr),
+             size,
+             demangle::typeName<std::remove_cv_t<std::remove_pointer_t<T>>>(),
              os);
 }
 
@@ -83,7 +483,7 @@ void dumpMemory(T&& var, std::ostream& os = std::cout) noexcept;
 
 template <typename T>
 void dumpMemory(T&& var, std::ostream& os) noexcept {
-  std::cout << "memDump::dumpMemory(T&& var,...) called before ...\n";
+  MEMDUMP_TRACE("memDump::dumpMemory(T&& var,...) called before ...\n");
   static_assert(std::is_reference<decltype(var)>::value,
                 "reference, or either lvalue or rvalue reference needed as arg 1 for dumpMemory()");
 
@@ -95,7 +495,7 @@ void dumpMemory(T& var, std::ostream& os = std::cout) noexcept;
 
 template <typename T>
 void dumpMemory(T& var, std::ostream& os) noexcept {
-  std::cout << "memDump::dumpMemory(T& var,...) called before ...\n";
+  MEMDUMP_TRACE("memDump::dumpMemory(T& var,...) called before ...\n");
   static_assert(std::is_reference<decltype(var)>::value,
                 "reference needed as arg 1 for dumpMemory()");
 
@@ -109,3 +509,7 @@ T* addressof(T& v) noexcept {
   return reinterpret_cast<T*>(& const_cast<char&>(reinterpret_cast<const volatile char&>(v)));
 }
 }  // namespace memDump
+
+#if defined(MEMDUMP_CALLSITE_STATS)
+#include "memDumpCallSites.h"
+#endif
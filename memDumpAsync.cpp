@@ -0,0 +1,197 @@
+//
+// memDumpAsync.cpp
+//
+#include "memDumpAsync.h"
+#include "memDumpMaps.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <unistd.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+// The ring is a bounded queue of slots with a sequence number each
+// (see D. Vyukov's bounded MPMC queue), here with a single consumer:
+// - a slot is free for the producer claiming position p when its sequence is p
+// - it is ready for the consumer at position p when its sequence is p + 1
+// - the consumer frees it for the next lap setting its sequence to p + slots
+AsyncDumper::AsyncDumper(const std::size_t slots,
+                         const std::size_t slotCapacity,
+                         std::ostream& os) :
+mask_(std::bit_ceil(std::max<std::size_t>(slots, 2)) - 1),
+slotCapacity_(slotCapacity),
+slots_(std::make_unique<Slot[]>(mask_ + 1)),
+payload_(std::make_unique<byte_t[]>((mask_ + 1) * slotCapacity)),
+os_(os)
+{
+  for (std::size_t i {0}; i <= mask_; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  worker_ = std::thread(&AsyncDumper::run, this);
+}
+
+AsyncDumper::~AsyncDumper() {
+  stop_.store(true, std::memory_order_release);
+  published_.fetch_add(1, std::memory_order_release);
+  published_.notify_one();
+  worker_.join();
+}
+
+bool AsyncDumper::dump(const void* ptr,
+                       const std::size_t size,
+                       const DumpOptions& options,
+                       const std::string_view demangledTypeName) noexcept {
+  return capture(ptr, size, options, demangledTypeName, false);
+}
+
+bool AsyncDumper::capture(const void* ptr,
+                          const std::size_t size,
+                          const DumpOptions& options,
+                          const std::string_view demangledTypeName,
+                          const bool staticTypeName) noexcept {
+  const DumpWindow window {dumpWindow(ptr, size, options)};
+  if (window.length() > slotCapacity_) {
+    oversized_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // claim a position whose slot is free
+  std::uint64_t position {enqueuePosition_.load(std::memory_order_relaxed)};
+  Slot* slot {nullptr};
+  for (;;) {
+    slot = &slots_[position & mask_];
+    const std::uint64_t sequence {slot->sequence.load(std::memory_order_acquire)};
+    const auto difference {static_cast<std::int64_t>(sequence - position)};
+    if (0 == difference) {
+      if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // the ring is full: the consumer is one lap behind
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      position = enqueuePosition_.load(std::memory_order_relaxed);
+    }
+  }
+
+  // fill the slot, then hand it to the consumer
+  slot->window = window;
+  slot->options = options;
+  slot->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  if (staticTypeName) {
+    slot->staticTypeName = demangledTypeName;
+    slot->typeNameSize = 0;
+  } else {
+    slot->staticTypeName = {};
+    slot->typeNameSize = std::min(demangledTypeName.size(), maxTypeNameSize);
+    std::memcpy(slot->typeName, demangledTypeName.data(), slot->typeNameSize);
+  }
+  byte_t* const payload {&payload_[(position & mask_) * slotCapacity_]};
+  slot->unreadableCount = 0;
+  if (!options.safeRead) {
+    std::memcpy(payload, reinterpret_cast<const byte_t*>(window.start()), window.length());
+  } else {
+    // the context may cross the edge of a mapping: copyMemory() stops at the
+    // first page it can't read, which is skipped
+    static const auto page {static_cast<uptr_t>(::sysconf(_SC_PAGESIZE))};
+    const uptr_t end {window.start() + window.length()};
+    for (uptr_t address {window.start()}; address < end; ) {
+      address += copyMemory(address, end - address, payload + (address - window.start()));
+      if (address < end) {
+        const Run run {static_cast<std::uint32_t>(address - window.start()),
+                       static_cast<std::uint32_t>(std::min((address / page + 1) * page, end) - window.start())};
+        std::size_t& count {slot->unreadableCount};
+        if ((count > 0) && (slot->unreadable[count - 1].end == run.begin)) {
+          slot->unreadable[count - 1].end = run.end;
+        } else if (count < maxUnreadableRuns) {
+          slot->unreadable[count++] = run;
+        } else {
+          slot->unreadable[count - 1].end = static_cast<std::uint32_t>(window.length());
+          break;
+        }
+        address = window.start() + run.end;
+      }
+    }
+  }
+  slot->sequence.store(position + 1, std::memory_order_release);
+
+  published_.fetch_add(1, std::memory_order_release);
+  published_.notify_one();
+  return true;
+}
+
+void AsyncDumper::flush() noexcept {
+  const std::uint64_t captured {enqueuePosition_.load(std::memory_order_acquire)};
+  std::uint64_t rendered {rendered_.load(std::memory_order_acquire)};
+  while (rendered < captured) {
+    rendered_.wait(rendered, std::memory_order_acquire);
+    rendered = rendered_.load(std::memory_order_acquire);
+  }
+}
+
+AsyncDumperStats AsyncDumper::stats() const noexcept {
+  return AsyncDumperStats {enqueuePosition_.load(std::memory_order_relaxed),
+                           rendered_.load(std::memory_order_relaxed),
+                           dropped_.load(std::memory_order_relaxed),
+                           oversized_.load(std::memory_order_relaxed)};
+}
+
+void AsyncDumper::run() noexcept {
+  for (;;) {
+    const std::uint64_t seen {published_.load(std::memory_order_acquire)};
+    while (renderNext()) {
+    }
+    reportDropped();
+    os_.flush();
+    if (stop_.load(std::memory_order_acquire)) {
+      break;
+    }
+    published_.wait(seen, std::memory_order_acquire);
+  }
+}
+
+bool AsyncDumper::renderNext() noexcept {
+  Slot& slot {slots_[dequeuePosition_ & mask_]};
+  if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition_ + 1) {
+    return false;  // empty, or the producer hasn't filled the slot yet
+  }
+
+  reportDropped();
+  os_ << "[memDump:asyncDump] captured at " << std::dec << slot.timestamp << " ns since epoch\n";
+  {
+    const byte_t* const payload {&payload_[(dequeuePosition_ & mask_) * slotCapacity_]};
+    DumpRenderer renderer {slot.window,
+                           slot.options,
+                           slot.staticTypeName.empty() ? std::string_view {slot.typeName, slot.typeNameSize}
+                                                       : slot.staticTypeName,
+                           os_};
+    uptr_t offset {0};
+    for (std::size_t i {0}; i < slot.unreadableCount; ++i) {
+      renderer.render(payload + offset, slot.unreadable[i].begin - offset);
+      renderer.renderUnreadable(slot.unreadable[i].end - slot.unreadable[i].begin);
+      offset = slot.unreadable[i].end;
+    }
+    renderer.render(payload + offset, slot.window.length() - offset);
+  }
+
+  slot.sequence.store(dequeuePosition_ + mask_ + 1, std::memory_order_release);
+  ++dequeuePosition_;
+  rendered_.fetch_add(1, std::memory_order_release);
+  rendered_.notify_all();
+  return true;
+}
+
+void AsyncDumper::reportDropped() noexcept {
+  const std::uint64_t dropped {dropped_.load(std::memory_order_relaxed)};
+  const std::uint64_t oversized {oversized_.load(std::memory_order_relaxed)};
+  if (dropped != droppedReported_ || oversized != oversizedReported_) {
+    os_ << "[memDump:asyncDump] records dropped: "
+        << std::dec << (dropped - droppedReported_) << " ring full, "
+        << (oversized - oversizedReported_) << " larger than "
+        << slotCapacity_ << " bytes\n";
+    droppedReported_ = dropped;
+    oversizedReported_ = oversized;
+  }
+}
+}  // namespace memDump
@@ -0,0 +1,127 @@
+//
+// memDumpAsync.h
+//
+// Asynchronous dumps: the calling thread only copies the bytes to dump, with
+// their context, into a preallocated lock-free ring; a background thread
+// formats them and does the I/O.
+//
+#pragma once
+
+#include "memDump.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <typeinfo>
+////////////////////////////////////////////////////////////////////////////////
+// in case we want to dump a variable asynchronously
+#define DMVA(dumper, var) (dumper).dump(&(var), sizeof(decltype(var)))
+// in case we want to dump asynchronously a memory of type type, pointed to by a pointer ptr
+#define DMPA(dumper, ptr, type) (dumper).dump(ptr, sizeof(type))
+
+namespace memDump
+{
+struct AsyncDumperStats {
+  std::uint64_t captured;  // records put in the ring
+  std::uint64_t rendered;  // records formatted by the background thread
+  std::uint64_t dropped;   // records dropped because the ring was full
+  std::uint64_t oversized; // records dropped because larger than a slot
+};
+
+// Overflow policy: a record is never waited for, nor does it overwrite
+// another one. When the ring is full the new record is dropped; when its
+// bytes and context don't fit in a slot it is dropped too. Both cases are
+// counted, and the background thread reports them in the output stream
+// before the next record it renders.
+class AsyncDumper final {
+public:
+  static constexpr std::size_t maxTypeNameSize {96};
+
+  // slots is rounded up to a power of 2; each slot holds up to slotCapacity
+  // bytes of memory, context included
+  explicit AsyncDumper(const std::size_t slots = 1024,
+                       const std::size_t slotCapacity = 512,
+                       std::ostream& os = std::cout);
+  // renders all the records captured, then stops the background thread
+  ~AsyncDumper();
+
+  AsyncDumper(const AsyncDumper&) = delete;
+  AsyncDumper& operator=(const AsyncDumper&) = delete;
+
+  // Capture size bytes at ptr with their context; return false if the
+  // record has been dropped. Never blocks, never allocates. With safeRead the
+  // bytes are copied with copyMemory() (memDumpMaps.h), and the pages that
+  // can't be read are rendered as unreadable
+  bool dump(const void* ptr,
+            const std::size_t size,
+            const DumpOptions& options,
+            const std::string_view demangledTypeName = {}) noexcept;
+
+  bool dump(const void* ptr, const std::size_t size) noexcept {
+    return dump(ptr, size, currentDumpOptions());
+  }
+
+  // the name of the type is a static string: it's not copied
+  template <typename T>
+  bool dump(const T* ptr, const std::size_t size) noexcept {
+    return capture(ptr, size, currentDumpOptions(), demangle::typeName<std::remove_cv_t<T>>(), true);
+  }
+
+  // wait until the background thread has rendered every record captured so far
+  void flush() noexcept;
+
+  AsyncDumperStats stats() const noexcept;
+
+private:
+  // the runs of unreadable bytes kept per record; the bytes after the last
+  // one are all rendered as unreadable if there are more
+  static constexpr std::size_t maxUnreadableRuns {4};
+
+  // bytes begin through end - 1 of the window of a record
+  struct Run {
+    std::uint32_t begin;
+    std::uint32_t end;
+  };
+
+  struct alignas(64) Slot {
+    std::atomic<std::uint64_t> sequence;
+    DumpWindow window;
+    DumpOptions options;
+    std::size_t unreadableCount;
+    Run unreadable[maxUnreadableRuns];
+    std::int64_t timestamp;  // ns since epoch
+    std::string_view staticTypeName;  // a type name never freed, not copied
+    std::size_t typeNameSize;
+    char typeName[maxTypeNameSize];
+  };
+
+  bool capture(const void* ptr,
+               const std::size_t size,
+               const DumpOptions& options,
+               const std::string_view demangledTypeName,
+               const bool staticTypeName) noexcept;
+  void run() noexcept;
+  bool renderNext() noexcept;
+  void reportDropped() noexcept;
+
+  const std::size_t mask_;
+  const std::size_t slotCapacity_;
+  std::unique_ptr<Slot[]> slots_;
+  std::unique_ptr<byte_t[]> payload_;  // slotCapacity_ bytes per slot
+  std::ostream& os_;
+
+  alignas(64) std::atomic<std::uint64_t> enqueuePosition_ {0};
+  alignas(64) std::atomic<std::uint64_t> published_ {0};  // the background thread waits on this
+  std::atomic<std::uint64_t> dropped_ {0};
+  std::atomic<std::uint64_t> oversized_ {0};
+
+  // owned by the background thread
+  alignas(64) std::uint64_t dequeuePosition_ {0};
+  std::uint64_t droppedReported_ {0};
+  std::uint64_t oversizedReported_ {0};
+  std::atomic<std::uint64_t> rendered_ {0};
+
+  std::atomic<bool> stop_ {false};
+  std::thread worker_;
+};
+}  // namespace memDump
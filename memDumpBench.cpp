@@ -0,0 +1,262 @@
+//
+// memDumpBench.cpp
+//
+// mem-dump-bench: throughput and allocations of memDump::dumpMemory()
+//
+// Sweeps region sizes from 1 B to 64 MB, start misalignments 0-15, fixed and
+// dynamic context, colors on and off, writing to a null sink and to a file.
+// For every combination it reports the dumped bytes per second, the ns spent
+// per printed row and the heap allocations per dumpMemory() call.
+//
+// With --threads the dumps are done by dumpMemoryParallel() on that many
+// worker threads, to compare it with the single thread dumpMemory().
+//
+// Usage: mem-dump-bench [--max-size <bytes>] [--min-time-ms <ms>] [--no-file] [--threads <n>]
+//
+#include "memDump.h"
+#include "memDumpParallel.h"
+#include "memDumpRegistry.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <streambuf>
+#include <string>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+// count every heap allocation done in the process: with the allocation
+// registry, which replaces the global operator new already, by its counter
+#if defined(MEMDUMP_ALLOCATION_REGISTRY)
+static std::size_t allocationCount() noexcept {
+  return memDump::allocationRegistryStats().allocated;
+}
+#else
+static std::atomic<std::size_t> allocations {0};
+
+static std::size_t allocationCount() noexcept {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p {std::malloc(size ? size : 1)}) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+  return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+  std::free(p);
+}
+#endif
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+// discards everything, counting the characters and rows written
+class nullStreamBuf final : public std::streambuf {
+public:
+  std::size_t rows() const noexcept {
+    return rows_;
+  }
+
+protected:
+  int_type overflow(int_type c) override {
+    if ('\n' == c) {
+      ++rows_;
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    for (std::streamsize i {0}; i < n; ++i) {
+      rows_ += ('\n' == s[i]);
+    }
+    return n;
+  }
+
+private:
+  std::size_t rows_ {0};
+};
+
+struct benchResult {
+  std::size_t calls {0};
+  std::size_t rows {0};
+  std::size_t allocations {0};
+  double seconds {0.0};
+};
+
+struct benchConfig {
+  std::size_t maxSize {64UL << 20};
+  std::chrono::milliseconds minTime {50};
+  bool fileSink {true};
+  unsigned threads {0};  // 0: dumpMemory(), else dumpMemoryParallel() with threads workers
+};
+
+const char* const fileSinkPath {"mem-dump-bench.out"};
+
+// the rows of a dump are: the separator, the header, an empty line, the ruler,
+// the memory rows and the closing separator; only the memory rows count
+constexpr std::size_t nonMemoryRows {5};
+
+benchResult runOne(const memDump::byte_t* ptr,
+                   const std::size_t size,
+                   const bool toFile,
+                   const benchConfig& config) {
+  benchResult result {};
+  nullStreamBuf nullBuf;
+  std::ostream nullSink {&nullBuf};
+  std::ofstream fileSink;
+  if (toFile) {
+    fileSink.open(fileSinkPath, std::ios::binary | std::ios::trunc);
+  }
+  std::ostream& os {toFile ? static_cast<std::ostream&>(fileSink) : nullSink};
+
+  const auto start {std::chrono::steady_clock::now()};
+  auto now {start};
+  do {
+    if (toFile) {
+      fileSink.seekp(0);
+    }
+    const auto allocationsBefore {allocationCount()};
+    if (0 == config.threads) {
+      memDump::dumpMemory(ptr, size, "", os);
+    } else {
+      memDump::dumpMemoryParallel(ptr, size, memDump::currentDumpOptions(), config.threads, {}, os);
+    }
+    result.allocations += allocationCount() - allocationsBefore;
+    ++result.calls;
+    now = std::chrono::steady_clock::now();
+  } while (now - start < config.minTime);
+  os.flush();
+
+  result.seconds = std::chrono::duration<double>(now - start).count();
+  if (!toFile) {
+    result.rows = nullBuf.rows() - result.calls * nonMemoryRows;
+  } else {
+    // same layout as the null sink: measure a single call there
+    nullStreamBuf countBuf;
+    std::ostream countSink {&countBuf};
+    memDump::dumpMemory(ptr, size, "", countSink);
+    result.rows = (countBuf.rows() - nonMemoryRows) * result.calls;
+  }
+  return result;
+}
+
+void printHeader() {
+  std::cout << std::left
+            << std::setw(10) << "size"
+            << std::setw(6)  << "mis"
+            << std::setw(9)  << "context"
+            << std::setw(7)  << "color"
+            << std::setw(6)  << "sink"
+            << std::right
+            << std::setw(10) << "calls"
+            << std::setw(14) << "MB/s"
+            << std::setw(12) << "ns/row"
+            << std::setw(12) << "allocs/call"
+            << "\n";
+}
+
+void printResult(const std::size_t size,
+                 const std::size_t misalignment,
+                 const bool fixedContext,
+                 const bool color,
+                 const bool toFile,
+                 const benchResult& r) {
+  const double bytesPerSec {static_cast<double>(size * r.calls) / r.seconds};
+  const double nsPerRow {r.seconds * 1e9 / static_cast<double>(r.rows ? r.rows : 1)};
+  std::cout << std::left << std::dec
+            << std::setw(10) << size
+            << std::setw(6)  << misalignment
+            << std::setw(9)  << (fixedContext ? "fixed" : "dynamic")
+            << std::setw(7)  << (color ? "on" : "off")
+            << std::setw(6)  << (toFile ? "file" : "null")
+            << std::right << std::fixed
+            << std::setw(10) << r.calls
+            << std::setw(14) << std::setprecision(2) << bytesPerSec / 1e6
+            << std::setw(12) << std::setprecision(2) << nsPerRow
+            << std::setw(12) << std::setprecision(2)
+            << static_cast<double>(r.allocations) / static_cast<double>(r.calls)
+            << "\n";
+}
+
+benchConfig parseArgs(int argc, char* argv[]) {
+  benchConfig config {};
+  for (int i {1}; i < argc; ++i) {
+    const std::string arg {argv[i]};
+    if ("--max-size" == arg && i + 1 < argc) {
+      config.maxSize = std::stoul(argv[++i]);
+    } else if ("--min-time-ms" == arg && i + 1 < argc) {
+      config.minTime = std::chrono::milliseconds(std::stoul(argv[++i]));
+    } else if ("--no-file" == arg) {
+      config.fileSink = false;
+    } else if ("--threads" == arg && i + 1 < argc) {
+      config.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--max-size <bytes>] [--min-time-ms <ms>] [--no-file] [--threads <n>]\n";
+      std::exit(EXIT_FAILURE);
+    }
+  }
+  return config;
+}
+}  // namespace
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[]) {
+  const benchConfig config {parseArgs(argc, argv)};
+
+  // room for the largest region, its misalignment and the context around it
+  constexpr std::size_t slack {4096};
+  std::vector<memDump::byte_t> memory(config.maxSize + 2 * slack);
+  for (std::size_t i {0}; i < memory.size(); ++i) {
+    memory[i] = static_cast<memDump::byte_t>(i * 131 + 7);
+  }
+  // 4096-aligned base so that misalignment 0 is really aligned to a row
+  const auto base {reinterpret_cast<memDump::uptr_t>(memory.data() + slack) & ~memDump::uptr_t {4095}};
+
+  printHeader();
+  for (std::size_t size {1}; size <= config.maxSize; size *= 4) {
+    for (std::size_t misalignment {0}; misalignment < 16; ++misalignment) {
+      const auto ptr {reinterpret_cast<const memDump::byte_t*>(base + misalignment)};
+      for (const bool fixedContext : {true, false}) {
+        if (fixedContext) {
+          memDump::setFixedContextOption();
+        } else {
+          memDump::setDynamicContextOption();
+        }
+        for (const bool color : {true, false}) {
+          memDump::setColorOption(color);
+          memDump::setAutoColorOption(false);  // colors in the files too
+          for (const bool toFile : {false, true}) {
+            if (toFile && !config.fileSink) {
+              continue;
+            }
+            printResult(size, misalignment, fixedContext, color, toFile,
+                        runOne(ptr, size, toFile, config));
+          }
+        }
+      }
+    }
+  }
+  std::remove(fileSinkPath);
+  return 0;
+}
@@ -0,0 +1,155 @@
+//
+// memDumpCacheLine.cpp
+//
+#include "memDumpCacheLine.h"
+#include "memDumpMaps.h"
+#include <algorithm>
+#include <iomanip>
+#include <unistd.h>
+#include <utility>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+uptr_t cacheLineSize() noexcept {
+  static const uptr_t size {[] {
+    const long size {::sysconf(_SC_LEVEL1_DCACHE_LINESIZE)};
+    return (size > 0) ? static_cast<uptr_t>(size) : uptr_t {64};
+  }()};
+  return size;
+}
+
+uptr_t cacheLinesSpanned(const void* ptr, const std::size_t size, const uptr_t lineSize) noexcept {
+  const uptr_t start {reinterpret_cast<uptr_t>(ptr)};
+  return (0 == size) ? 0 : (start + size - 1) / lineSize - start / lineSize + 1;
+}
+
+std::vector<SharedCacheLine> findFalseSharing(const OwnedRegion* regions,
+                                              const std::size_t count,
+                                              const uptr_t lineSize) {
+  // every (line, region) touching, sorted by line
+  std::vector<std::pair<uptr_t, std::size_t>> touches;
+  for (std::size_t i {0}; i < count; ++i) {
+    const uptr_t start {reinterpret_cast<uptr_t>(regions[i].ptr)};
+    for (uptr_t line {start / lineSize}, n {0}; n < cacheLinesSpanned(regions[i].ptr, regions[i].size, lineSize); ++line, ++n) {
+      touches.emplace_back(line * lineSize, i);
+    }
+  }
+  std::sort(touches.begin(), touches.end());
+
+  std::vector<SharedCacheLine> shared;
+  for (auto touch {touches.begin()}; touches.end() != touch; ) {
+    auto next {touch};
+    bool owners {false};  // more than one
+    for (; (touches.end() != next) && (next->first == touch->first); ++next) {
+      owners = owners || (regions[next->second].owner != regions[touch->second].owner);
+    }
+    if (owners) {
+      SharedCacheLine line {touch->first, {}};
+      for (; touch != next; ++touch) {
+        line.regions.push_back(touch->second);
+      }
+      shared.push_back(std::move(line));
+    }
+    touch = next;
+  }
+  return shared;
+}
+
+std::size_t dumpFalseSharing(const OwnedRegion* regions,
+                             const std::size_t count,
+                             std::ostream& os) noexcept {
+  return dumpFalseSharing(regions, count, currentDumpOptions(), os);
+}
+
+std::size_t dumpFalseSharing(const OwnedRegion* regions,
+                             const std::size_t count,
+                             const DumpOptions& options,
+                             std::ostream& os) noexcept {
+  // the stream is given back formatted as the caller left it
+  const std::ios_base::fmtflags flags {os.flags()};
+  const char fill {os.fill()};
+  std::size_t sharedLines {0};
+  try {
+    const uptr_t lineSize {(options.cacheLineSize > 0) ? options.cacheLineSize : cacheLineSize()};
+    const std::vector<SharedCacheLine> shared {findFalseSharing(regions, count, lineSize)};
+    const bool color {useColors(options, os)};
+    const std::string_view reset {color ? std::string_view {RESET_COLOR} : std::string_view {}};
+    auto colorOf = [color](const std::size_t region) -> std::string_view {
+      return color ? RANGE_COLORS[region % RANGE_COLOR_COUNT] : std::string_view {};
+    };
+
+    os << "[memDump:dumpFalseSharing]----------------------------------------------\n"
+       << std::dec << count << " regions, cache lines of " << lineSize << " bytes\n\n"
+       << std::setfill(' ')
+       << "  address           size      owner  lines  region\n";
+    for (std::size_t i {0}; i < count; ++i) {
+      os << "  " << regions[i].ptr << std::setw(8) << regions[i].size
+         << std::setw(11) << regions[i].owner
+         << std::setw(7) << cacheLinesSpanned(regions[i].ptr, regions[i].size, lineSize)
+         << "  " << colorOf(i) << regions[i].name << reset << "\n";
+    }
+
+    HighlightRowRenderer renderer {options, os};
+    const uptr_t rowWidth {renderer.rowWidth()};
+    std::string_view colors[DumpOptions::maxRowWidth];
+    char markers[DumpOptions::maxRowWidth + 1];
+    for (const SharedCacheLine& line : shared) {
+      os << "\ncache line " << reinterpret_cast<const void*>(line.address) << " shared by";
+      for (const std::size_t region : line.regions) {
+        os << " " << colorOf(region) << regions[region].name << reset << " (" << regions[region].owner << ")";
+      }
+      os << "\n\n";
+      renderer.ruler();
+
+      // each region in its color, between < and >
+      for (uptr_t rowStart {line.address - line.address % rowWidth}; rowStart < line.address + lineSize; rowStart += rowWidth) {
+        const uptr_t first {std::max(rowStart, line.address) - rowStart};
+        const uptr_t last {std::min(rowWidth, line.address + lineSize - rowStart)};
+        for (uptr_t i {0}; i <= rowWidth; ++i) {
+          const uptr_t a {rowStart + i};
+          markers[i] = ' ';
+          if (i < rowWidth) {
+            colors[i] = {};
+          }
+          for (const std::size_t region : line.regions) {
+            const uptr_t start {reinterpret_cast<uptr_t>(regions[region].ptr)};
+            const uptr_t end {start + regions[region].size};
+            if (a == start) {
+              markers[i] = (' ' == markers[i]) ? '<' : '|';
+            } else if (a == end) {
+              markers[i] = (' ' == markers[i]) ? '>' : '|';
+            }
+            if ((i < rowWidth) && (a >= start) && (a < end)) {
+              colors[i] = colorOf(region);
+            }
+          }
+        }
+
+        const uptr_t address {rowStart + first};
+        // read through copyMemory() with safeRead
+        byte_t copy[DumpOptions::maxRowWidth];
+        const byte_t* bytes {reinterpret_cast<const byte_t*>(address)};
+        if (options.safeRead) {
+          bytes = (copyMemory(address, last - first, copy) == last - first) ? copy : nullptr;
+        }
+        renderer.styledRow(rowStart,
+                           bytes,
+                           first,
+                           last - first,
+                           colors,
+                           markers);
+      }
+      os << "\n";
+    }
+
+    os << "\n" << shared.size() << " cache line" << ((1 == shared.size()) ? "" : "s")
+       << " shared by different owners\n";
+    os << "-----------------------------------------------------------------------\n";
+    sharedLines = shared.size();
+  } catch (...) {
+    os << "[memDump:dumpFalseSharing] out of memory\n";
+  }
+  os.flags(flags);
+  os.fill(fill);
+  return sharedLines;
+}
+}  // namespace memDump
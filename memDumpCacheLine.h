@@ -0,0 +1,52 @@
+//
+// memDumpCacheLine.h
+//
+// Cache lines of the dumped memory, and a false-sharing detector: regions
+// written by different threads that share a cache line
+//
+#pragma once
+
+#include "memDump.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+// the size of the L1 data cache lines of the machine; 64 if unknown
+uptr_t cacheLineSize() noexcept;
+
+// the cache lines of lineSize bytes that size bytes at ptr touch
+uptr_t cacheLinesSpanned(const void* ptr, const std::size_t size, const uptr_t lineSize = cacheLineSize()) noexcept;
+
+// a region of memory written by a thread, e.g. a hot field or a counter
+struct OwnedRegion {
+  const void* ptr;
+  std::size_t size;
+  std::uint64_t owner;    // the thread writing the region: any id, e.g. gettid()
+  std::string_view name;  // shown in the report
+};
+
+// a cache line touched by regions of more than one owner
+struct SharedCacheLine {
+  uptr_t address;
+  std::vector<std::size_t> regions;  // indexes of all the regions touching the line
+};
+
+// The cache lines shared by regions of different owners, by address
+std::vector<SharedCacheLine> findFalseSharing(const OwnedRegion* regions,
+                                              const std::size_t count,
+                                              const uptr_t lineSize = cacheLineSize());
+
+// Report the cache lines each region spans, then dump each cache line shared
+// by different owners with its regions in their own colors; return the number
+// of lines shared
+std::size_t dumpFalseSharing(const OwnedRegion* regions,
+                             const std::size_t count,
+                             const DumpOptions& options,
+                             std::ostream& os = std::cout) noexcept;
+
+std::size_t dumpFalseSharing(const OwnedRegion* regions,
+                             const std::size_t count,
+                             std::ostream& os = std::cout) noexcept;
+}  // namespace memDump
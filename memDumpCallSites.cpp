@@ -0,0 +1,201 @@
+//
+// memDumpCallSites.cpp
+//
+#include "memDumpCallSites.h"
+#include <algorithm>
+#if defined(MEMDUMP_CALLSITE_STATS)
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <new>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+#if defined(MEMDUMP_CALLSITE_STATS)
+namespace {
+// the counters of a call site in a shard, written only by the thread of the
+// shard: atomics for the merges to read them, without read-modify-writes
+struct Counters {
+  std::atomic<std::uint64_t> calls;
+  std::atomic<std::uint64_t> bytesInspected;
+  std::atomic<std::uint64_t> bytesWritten;
+  std::atomic<std::uint64_t> ticks;
+};
+
+// the counters of a thread
+struct Shard {
+  Counters counters[CallSite::maxCount];
+};
+
+std::atomic<const CallSite*> sites[CallSite::maxCount] {};
+std::atomic<std::size_t> siteCount {0};
+
+std::mutex shardsMutex;
+std::vector<Shard*> shards;  // of the running threads
+Shard retired {};            // the sums of the threads ended, under shardsMutex
+
+thread_local Shard* threadShard {nullptr};
+
+// the counters of the threads ended are kept
+struct ShardRetirer {
+  ~ShardRetirer() {
+    const std::lock_guard<std::mutex> lock {shardsMutex};
+    for (std::size_t i {0}; i < CallSite::maxCount; ++i) {
+      const Counters& from {threadShard->counters[i]};
+      Counters& to {retired.counters[i]};
+      to.calls.fetch_add(from.calls.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      to.bytesInspected.fetch_add(from.bytesInspected.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      to.bytesWritten.fetch_add(from.bytesWritten.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      to.ticks.fetch_add(from.ticks.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    shards.erase(std::find(shards.begin(), shards.end(), threadShard));
+    delete threadShard;
+    threadShard = nullptr;
+  }
+};
+
+Shard* newThreadShard() noexcept {
+  auto* const shard {new (std::nothrow) Shard {}};
+  if (nullptr == shard) {
+    return nullptr;
+  }
+  try {
+    const std::lock_guard<std::mutex> lock {shardsMutex};
+    shards.push_back(shard);
+  } catch (...) {
+    delete shard;
+    return nullptr;
+  }
+  threadShard = shard;
+  thread_local ShardRetirer retirer {};
+  (void) retirer;
+  return shard;
+}
+
+void add(Counters& counter, const std::uint64_t bytesInspected, const std::uint64_t bytesWritten,
+         const std::uint64_t ticks) noexcept {
+  auto increase = [](std::atomic<std::uint64_t>& value, const std::uint64_t n) noexcept {
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  };
+  increase(counter.calls, 1);
+  increase(counter.bytesInspected, bytesInspected);
+  increase(counter.bytesWritten, bytesWritten);
+  increase(counter.ticks, ticks);
+}
+
+// the ticks and the time at startup, to convert ticks to nanoseconds
+const std::uint64_t startTicks {CallSite::ticks()};
+const std::chrono::steady_clock::time_point startTime {std::chrono::steady_clock::now()};
+
+double nanosecondsPerTick() noexcept {
+  // the counter measured against the clock since startup, a millisecond at least
+  auto elapsed = [] { return std::chrono::steady_clock::now() - startTime; };
+  while (elapsed() < std::chrono::milliseconds {1}) {
+  }
+  const auto nanoseconds {std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed()).count()};
+  const std::uint64_t ticks {CallSite::ticks() - startTicks};
+  return (0 == ticks) ? 1.0 : static_cast<double>(nanoseconds) / static_cast<double>(ticks);
+}
+}  // namespace
+
+CallSite::CallSite(const std::source_location& location) noexcept :
+location(location),
+index(std::min(siteCount.fetch_add(1, std::memory_order_relaxed), maxCount))
+{
+  if (index < maxCount) {
+    sites[index].store(this, std::memory_order_release);
+  }
+}
+
+std::uint64_t CallSite::ticks() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  std::uint64_t ticks;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+#else
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+void CallSite::record(const std::size_t bytesInspected, const std::size_t bytesWritten, const std::uint64_t elapsed) noexcept {
+  if (index >= maxCount) {
+    return;
+  }
+  Shard* const shard {(nullptr != threadShard) ? threadShard : newThreadShard()};
+  if (nullptr != shard) {
+    add(shard->counters[index], bytesInspected, bytesWritten, elapsed);
+  }
+}
+
+std::vector<CallSiteStats> callSiteStats(const std::size_t top) {
+  const std::size_t count {std::min(siteCount.load(std::memory_order_acquire), CallSite::maxCount)};
+  std::vector<CallSiteStats> stats;
+  stats.reserve(count);
+  std::vector<std::uint64_t> ticks(count, 0);
+  for (std::size_t i {0}; i < count; ++i) {
+    const CallSite* site {sites[i].load(std::memory_order_acquire)};
+    // numbered, not published yet
+    stats.push_back(CallSiteStats {(nullptr != site) ? site->location : std::source_location {}, 0, 0, 0, 0});
+  }
+
+  {
+    const std::lock_guard<std::mutex> lock {shardsMutex};
+    auto merge = [&](const Shard& shard) {
+      for (std::size_t i {0}; i < count; ++i) {
+        const Counters& counters {shard.counters[i]};
+        stats[i].calls += counters.calls.load(std::memory_order_relaxed);
+        stats[i].bytesInspected += counters.bytesInspected.load(std::memory_order_relaxed);
+        stats[i].bytesWritten += counters.bytesWritten.load(std::memory_order_relaxed);
+        ticks[i] += counters.ticks.load(std::memory_order_relaxed);
+      }
+    };
+    merge(retired);
+    for (const Shard* shard : shards) {
+      merge(*shard);
+    }
+  }
+
+  const double tickNanoseconds {nanosecondsPerTick()};
+  for (std::size_t i {0}; i < count; ++i) {
+    stats[i].nanoseconds = static_cast<std::uint64_t>(static_cast<double>(ticks[i]) * tickNanoseconds);
+  }
+  std::erase_if(stats, [](const CallSiteStats& s) { return 0 == s.calls; });
+  std::sort(stats.begin(), stats.end(),
+            [](const CallSiteStats& a, const CallSiteStats& b) { return a.nanoseconds > b.nanoseconds; });
+  stats.resize(std::min(stats.size(), top));
+  return stats;
+}
+#else
+std::vector<CallSiteStats> callSiteStats(const std::size_t) {
+  return {};
+}
+#endif
+
+void printCallSiteStats(const std::size_t top, std::ostream& os) noexcept {
+  if (!callSiteStatsEnabled) {
+    std::cerr << "memDump::printCallSiteStats: built without MEMDUMP_CALLSITE_STATS\n";
+    return;
+  }
+  try {
+    const std::vector<CallSiteStats> stats {callSiteStats(top)};
+    const char fill {os.fill(' ')};
+    os << "[memDump:callSites] " << std::dec << stats.size() << " call sites by formatting time\n"
+       << std::setw(10) << "calls" << std::setw(12) << "inspected" << std::setw(12)
+       << "written" << std::setw(12) << "ns/call" << "  location\n";
+    for (const CallSiteStats& s : stats) {
+      os << std::setw(10) << s.calls << std::setw(12) << s.bytesInspected << std::setw(12) << s.bytesWritten
+         << std::setw(12) << s.nanoseconds / s.calls << "  " << s.location.file_name() << ":"
+         << s.location.line() << " " << s.location.function_name() << "\n";
+    }
+    os.fill(fill);
+  } catch (...) {
+    std::cerr << "memDump::printCallSiteStats: out of memory\n";
+  }
+}
+}  // namespace memDump
@@ -0,0 +1,94 @@
+//
+// memDumpCallSites.h
+//
+// Statistics of the DMV() and DMP() call sites: calls, bytes inspected, bytes
+// written and formatting time of each one, to find the dumps that cost. It's
+// compiled in only with MEMDUMP_CALLSITE_STATS defined
+// (cmake -DMEMDUMP_CALLSITE_STATS=ON); otherwise the macros dump as they
+// always did and there are no statistics
+//
+#pragma once
+
+#include "memDump.h"
+#include <cstdint>
+#include <iomanip>
+#include <source_location>
+#include <type_traits>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+#if defined(MEMDUMP_CALLSITE_STATS)
+constexpr bool callSiteStatsEnabled {true};
+#else
+constexpr bool callSiteStatsEnabled {false};
+#endif
+
+struct CallSiteStats {
+  std::source_location location;
+  std::uint64_t calls;
+  std::uint64_t bytesInspected;  // dumped, without the context
+  std::uint64_t bytesWritten;
+  std::uint64_t nanoseconds;     // formatting and writing
+};
+
+// The statistics of the call sites, merged from all the threads, the most
+// expensive first; top of them at most
+std::vector<CallSiteStats> callSiteStats(const std::size_t top = static_cast<std::size_t>(-1));
+
+// print the top call sites as a table
+void printCallSiteStats(const std::size_t top = 10, std::ostream& os = std::cout) noexcept;
+
+#if defined(MEMDUMP_CALLSITE_STATS)
+// A call site of the macros, a static of its own, numbered when first reached.
+// Its counters are in per-thread shards, updated without atomic operations,
+// merged by callSiteStats()
+class CallSite final {
+public:
+  // the number of call sites with statistics; the ones after aren't counted
+  static constexpr std::size_t maxCount {1024};
+
+  explicit CallSite(const std::source_location& location) noexcept;
+
+  CallSite(const CallSite&) = delete;
+  CallSite& operator=(const CallSite&) = delete;
+
+  // add a call of elapsed ticks (see ticks()) to the shard of the thread
+  void record(const std::size_t bytesInspected, const std::size_t bytesWritten, const std::uint64_t elapsed) noexcept;
+
+  // a time stamp, in the ticks of the cycle counter where there is one
+  static std::uint64_t ticks() noexcept;
+
+  const std::source_location location;
+  const std::size_t index;
+};
+
+// dump like dumpMemory(ptr, size) does, counting the call for site
+template <typename T>
+void dumpMemoryAt(CallSite& site, const T ptr, const std::size_t size) noexcept {
+  static_assert(std::is_pointer<T>::value, "pointer needed as arg 2 for dumpMemoryAt()");
+
+  OstreamSink out {std::cout};
+  CountingSink counted {out};
+  const std::uint64_t start {CallSite::ticks()};
+  dumpMemory(reinterpret_cast<const void*>(ptr),
+             size,
+             currentDumpOptions(),
+             demangle::typeName<std::remove_cv_t<std::remove_pointer_t<T>>>(),
+             counted);
+  site.record(size, counted.count(), CallSite::ticks() - start);
+  // the stream left in the state of the dumps to an std::ostream
+  std::cout << std::hex << std::uppercase << std::setfill('0');
+}
+#endif
+}  // namespace memDump
+
+#if defined(MEMDUMP_CALLSITE_STATS)
+// the CallSite of the expansion of the macro, a static of its own lambda;
+// the location is the one of the caller
+#define MEMDUMP_CALL_SITE                                                          \
+  [](const std::source_location& location) -> memDump::CallSite& {                 \
+    static memDump::CallSite site {location};                                      \
+    return site;                                                                   \
+  }(std::source_location::current())
+#endif
@@ -0,0 +1,223 @@
+//
+// memDumpCapture.cpp
+//
+#include "memDumpCapture.h"
+#include "memDumpMaps.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+namespace {
+bool fail(const char* path, const char* what) noexcept {
+  std::cerr << "memDump::renderCaptureFile: " << path << ": " << what << ": " << std::strerror(errno) << "\n";
+  return false;
+}
+}  // namespace
+
+CaptureWriter::CaptureWriter(const char* path, const std::size_t bufferSize) noexcept :
+fd_(::open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)),
+buffer_(new (std::nothrow) byte_t[bufferSize]),
+bufferSize_(buffer_ ? bufferSize : 0)
+{
+  if (fd_ < 0) {
+    std::cerr << "memDump::CaptureWriter: " << path << ": open: " << std::strerror(errno) << "\n";
+  }
+}
+
+CaptureWriter::~CaptureWriter() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+bool CaptureWriter::capture(const void* ptr,
+                            const std::size_t size,
+                            const DumpOptions& options,
+                            const std::string_view typeName) noexcept {
+  if (fd_ < 0) {
+    return false;
+  }
+  const DumpWindow window {dumpWindow(ptr, size, options)};
+  if (options.safeRead && (window.length() > bufferSize_)) {
+    return false;
+  }
+  std::unique_lock<std::mutex> lock {bufferMutex_, std::defer_lock};
+  if (options.safeRead) {
+    lock.lock();
+  }
+
+  // the runs of the window with the same readability
+  CaptureRun runs[maxRuns];
+  std::size_t runCount {0};
+  auto addRun = [&](const uptr_t length, const bool readable) noexcept -> bool {
+    if (0 == length) {
+      return true;
+    }
+    if ((runCount > 0) && (readable == (0 != runs[runCount - 1].readable))) {
+      runs[runCount - 1].length += length;
+      return true;
+    }
+    if (maxRuns == runCount) {
+      return false;
+    }
+    runs[runCount++] = CaptureRun {length, readable};
+    return true;
+  };
+  const uptr_t start {window.start()};
+  const uptr_t end {start + window.length()};
+  if (!options.safeRead) {
+    if (start < end) {
+      addRun(window.length(), true);
+    }
+  } else {
+    // the window is copied a page at a time by a system call, which fails on
+    // the pages not readable, whatever the mappings were when last read
+    static const auto page {static_cast<uptr_t>(::sysconf(_SC_PAGESIZE))};
+    for (uptr_t address {start}; address < end; ) {
+      const uptr_t readableEnd {address + copyMemory(address, end - address, &buffer_[address - start])};
+      const uptr_t unreadableEnd {(readableEnd < end) ? std::min((readableEnd / page + 1) * page, end) : end};
+      if (!addRun(readableEnd - address, true) || !addRun(unreadableEnd - readableEnd, false)) {
+        // no runs left: the rest of the window is recorded as unreadable
+        uptr_t before {0};
+        for (std::size_t i {0}; i < maxRuns - 1; ++i) {
+          before += runs[i].length;
+        }
+        runs[maxRuns - 1] = CaptureRun {window.length() - before, false};
+        break;
+      }
+      address = unreadableEnd;
+    }
+  }
+
+  // header, name, runs, then the bytes of each readable run, from the buffer
+  // with safeRead
+  CaptureRecordHeader header {};
+  iovec iov[3 + maxRuns];
+  int iovCount {3};
+  std::uint64_t recordSize {sizeof(header) + typeName.size() + runCount * sizeof(CaptureRun)};
+  uptr_t offset {0};
+  for (std::size_t i {0}; i < runCount; ++i) {
+    if (0 != runs[i].readable) {
+      iov[iovCount++] = iovec {options.safeRead ? static_cast<void*>(&buffer_[offset])
+                                                : reinterpret_cast<void*>(start + offset),
+                               runs[i].length};
+      recordSize += runs[i].length;
+    }
+    offset += runs[i].length;
+  }
+
+  header.magic = CaptureRecordHeader::recordMagic;
+  header.flags = 0;
+  header.recordSize = recordSize;
+  header.address = window.address;
+  header.size = window.size;
+  header.preBufferSize = window.preBufferSize;
+  header.postBufferSize = window.postBufferSize;
+  header.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  header.nameSize = static_cast<std::uint32_t>(typeName.size());
+  header.runs = static_cast<std::uint32_t>(runCount);
+  iov[0] = iovec {&header, sizeof(header)};
+  iov[1] = iovec {const_cast<char*>(typeName.data()), typeName.size()};
+  iov[2] = iovec {runs, runCount * sizeof(CaptureRun)};
+
+  // a regular file opened with O_APPEND gets the whole record at its end
+  ssize_t written {};
+  do {
+    written = ::writev(fd_, iov, iovCount);
+  } while ((written < 0) && (EINTR == errno));
+  if (static_cast<std::uint64_t>(written) == recordSize) {
+    return true;
+  }
+  if (written > 0) {
+    // the part of the record written would make the rest of the log
+    // unreadable: the log is cut back to where the record started
+    const off_t logEnd {::lseek(fd_, 0, SEEK_CUR)};
+    if ((logEnd < written) || (::ftruncate(fd_, logEnd - written) < 0)) {
+      std::cerr << "memDump::CaptureWriter: record written in part: " << std::strerror(errno) << "\n";
+    }
+  }
+  return false;
+}
+
+bool renderCaptureFile(const char* path, std::ostream& os) noexcept {
+  return renderCaptureFile(path, currentDumpOptions(), os);
+}
+
+bool renderCaptureFile(const char* path,
+                       const DumpOptions& options,
+                       std::ostream& os) noexcept {
+  const int fd {::open(path, O_RDONLY | O_CLOEXEC)};
+  if (fd < 0) {
+    return fail(path, "open");
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) < 0) {
+    const bool result {fail(path, "fstat")};
+    ::close(fd);
+    return result;
+  }
+  const auto fileSize {static_cast<std::uint64_t>(st.st_size)};
+  if (0 == fileSize) {
+    ::close(fd);
+    return true;
+  }
+  void* const mapped {::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0)};
+  ::close(fd);
+  if (MAP_FAILED == mapped) {
+    return fail(path, "mmap");
+  }
+  ::madvise(mapped, fileSize, MADV_SEQUENTIAL);
+
+  const auto* const log {static_cast<const byte_t*>(mapped)};
+  bool result {true};
+  std::uint64_t record {0};
+  for (std::uint64_t offset {0}; offset < fileSize; ++record) {
+    // the records aren't aligned: copy the fixed parts out of the log
+    CaptureRecordHeader header {};
+    const std::uint64_t left {fileSize - offset};
+    if (left >= sizeof(header)) {
+      std::memcpy(&header, log + offset, sizeof(header));
+    }
+    const std::uint64_t fixedSize {sizeof(header) + header.nameSize + std::uint64_t {header.runs} * sizeof(CaptureRun)};
+    if ((left < sizeof(header)) || (CaptureRecordHeader::recordMagic != header.magic) ||
+        (header.recordSize > left) || (fixedSize > header.recordSize)) {
+      std::cerr << "memDump::renderCaptureFile: " << path << ": record " << record
+                << " at offset " << offset << " is corrupt or truncated\n";
+      result = false;
+      break;
+    }
+
+    const byte_t* const name {log + offset + sizeof(header)};
+    const byte_t* const runs {name + header.nameSize};
+    const byte_t* bytes {runs + header.runs * sizeof(CaptureRun)};
+    const DumpWindow window {header.address, header.size, header.preBufferSize, header.postBufferSize};
+    const std::string_view typeName {reinterpret_cast<const char*>(name), header.nameSize};
+
+    os << "[memDump:renderCaptureFile] record " << std::dec << record
+       << " captured at " << header.timestamp << " ns since epoch\n";
+    DumpRenderer renderer {window, options, typeName, os};
+    const byte_t* const end {log + offset + header.recordSize};
+    for (std::uint32_t i {0}; i < header.runs; ++i) {
+      CaptureRun run {};
+      std::memcpy(&run, runs + i * sizeof(CaptureRun), sizeof(run));
+      if (0 == run.readable) {
+        renderer.renderUnreadable(run.length);
+      } else {
+        const uptr_t length {std::min<uptr_t>(run.length, end - bytes)};
+        renderer.render(bytes, length);
+        bytes += length;
+      }
+    }
+    offset += header.recordSize;
+  }
+  ::munmap(mapped, fileSize);
+  return result;
+}
+}  // namespace memDump
@@ -0,0 +1,98 @@
+//
+// memDumpCapture.h
+//
+// Captures of memory to a binary log, as cheap as a copy of the bytes, and
+// the offline rendering of the log in the layout of dumpMemory()
+//
+#pragma once
+
+#include "memDump.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+// A record of the log: the header, then nameSize bytes of type name, then
+// runs CaptureRun, then the bytes of the readable runs. All the fields are in
+// the byte order of the host that captured them
+struct CaptureRecordHeader {
+  static constexpr std::uint32_t recordMagic {0x3152444D};  // "MDR1"
+
+  std::uint32_t magic;
+  std::uint32_t flags;           // none yet: 0
+  std::uint64_t recordSize;      // header included
+  std::uint64_t address;         // of the data
+  std::uint64_t size;            // of the data
+  std::uint64_t preBufferSize;   // context before the data
+  std::uint64_t postBufferSize;  // context after the data
+  std::int64_t timestamp;        // ns since epoch
+  std::uint32_t nameSize;
+  std::uint32_t runs;
+};
+
+// a run of the window with the same readability; its bytes are in the record
+// only if readable
+struct CaptureRun {
+  std::uint64_t length;
+  std::uint64_t readable;
+};
+
+// Appends records to a log file opened with O_APPEND: each record is written
+// with a single writev(), so records of concurrent writers don't interleave,
+// and a record written in part, e.g. on a full disk, is truncated away. With
+// safeRead the window is first copied a page at a time with copyMemory()
+// (memDumpMaps.h) into the buffer of the writer, allocated once; without it
+// the bytes are written straight from the memory. Capturing formats nothing
+// and allocates nothing
+class CaptureWriter final {
+public:
+  // the runs a record can describe; the memory past them is recorded as
+  // unreadable
+  static constexpr std::size_t maxRuns {32};
+
+  // with safeRead, windows of up to bufferSize bytes, context included, can
+  // be captured
+  explicit CaptureWriter(const char* path, const std::size_t bufferSize = 64 * 1024) noexcept;
+  ~CaptureWriter();
+
+  CaptureWriter(const CaptureWriter&) = delete;
+  CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+  bool isOpen() const noexcept {
+    return fd_ >= 0;
+  }
+
+  // Append a record of size bytes at ptr with the context of options; with
+  // options.safeRead only the readable pages are recorded. Return false if
+  // the record can't be written, or doesn't fit in the buffer
+  bool capture(const void* ptr,
+               const std::size_t size,
+               const DumpOptions& options,
+               const std::string_view demangledTypeName = {}) noexcept;
+
+  bool capture(const void* ptr, const std::size_t size) noexcept {
+    return capture(ptr, size, currentDumpOptions());
+  }
+
+  template <typename T>
+  bool capture(const T& var) noexcept {
+    return capture(&var, sizeof(var), currentDumpOptions(), demangle::typeName<T>());
+  }
+
+private:
+  int fd_ {-1};
+  std::mutex bufferMutex_;  // serializes the captures with safeRead, sharing the buffer
+  const std::unique_ptr<byte_t[]> buffer_;
+  const std::size_t bufferSize_;
+};
+
+// Render every record of the log at path with the layout of options; the
+// context of each record is the one it was captured with. Return false, with
+// a message on std::cerr, if the log can't be read or a record is corrupt
+bool renderCaptureFile(const char* path,
+                       const DumpOptions& options,
+                       std::ostream& os = std::cout) noexcept;
+
+bool renderCaptureFile(const char* path, std::ostream& os = std::cout) noexcept;
+}  // namespace memDump
@@ -0,0 +1,286 @@
+//
+// memDumpCrash.cpp
+//
+// Everything the handler calls is async-signal-safe: the renderer writes to
+// an FdSink on the stack, and the memory is read with process_vm_readv(), or
+// write()s to a pipe, which fail with EFAULT on unreadable pages instead of
+// faulting
+//
+#include "memDumpCrash.h"
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/ucontext.h>
+#include <sys/uio.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+namespace {
+constexpr int crashSignals[] {SIGSEGV, SIGBUS, SIGABRT};
+constexpr std::size_t signalCount {std::size(crashSignals)};
+// the memory is read in chunks never crossing a page
+constexpr uptr_t readChunkSize {4096};
+constexpr std::size_t altStackSize {128 * 1024};
+
+// set up by installCrashHandler(), read by the handler
+CrashHandlerOptions crashOptions {};
+DumpOptions crashDumpOptions {};
+int probePipe[2] {-1, -1};
+bool installed {false};
+struct sigaction previousActions[signalCount] {};
+std::atomic<bool> crashing {false};
+
+struct AltStack {
+  void* memory {nullptr};
+
+  ~AltStack() {
+    if (nullptr != memory) {
+      stack_t disable {};
+      disable.ss_flags = SS_DISABLE;
+      ::sigaltstack(&disable, nullptr);
+      ::munmap(memory, altStackSize);
+    }
+  }
+};
+thread_local AltStack altStack {};
+
+const char* signalName(const int signal) noexcept {
+  switch (signal) {
+    case SIGSEGV: return "SIGSEGV";
+    case SIGBUS:  return "SIGBUS";
+    case SIGABRT: return "SIGABRT";
+    default:      return "signal";
+  }
+}
+
+const char* codeName(const int signal, const int code) noexcept {
+  if (SIGSEGV == signal) {
+    switch (code) {
+      case SEGV_MAPERR: return "SEGV_MAPERR: address not mapped";
+      case SEGV_ACCERR: return "SEGV_ACCERR: no permission";
+      default: break;
+    }
+  } else if (SIGBUS == signal) {
+    switch (code) {
+      case BUS_ADRALN: return "BUS_ADRALN: misaligned address";
+      case BUS_ADRERR: return "BUS_ADRERR: address not backed";
+      default: break;
+    }
+  }
+  return (code <= 0) ? "sent by a process" : "";
+}
+
+void writeDecimal(Sink& sink, std::uint64_t value) noexcept {
+  char digits[20];
+  std::size_t count {sizeof(digits)};
+  do {
+    digits[--count] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  sink.write(digits + count, sizeof(digits) - count);
+}
+
+// "0x" and the 16 hex digits of value
+void writeHex(Sink& sink, uptr_t value) noexcept {
+  char digits[18] {'0', 'x'};
+  for (int i {17}; i >= 2; --i, value >>= 4) {
+    digits[i] = "0123456789ABCDEF"[value & 0xF];
+  }
+  sink.write(digits, sizeof(digits));
+}
+
+void writeRegister(Sink& sink, const std::string_view name, const uptr_t value) noexcept {
+  sink.write(name);
+  sink.write(" ");
+  writeHex(sink, value);
+}
+
+void writeRegisters(Sink& sink, const ucontext_t* context) noexcept {
+#if defined(__x86_64__)
+  const greg_t* regs {context->uc_mcontext.gregs};
+  writeRegister(sink, "rip", static_cast<uptr_t>(regs[REG_RIP]));
+  writeRegister(sink, "  rsp", static_cast<uptr_t>(regs[REG_RSP]));
+  writeRegister(sink, "  rbp", static_cast<uptr_t>(regs[REG_RBP]));
+  writeRegister(sink, "\nrax", static_cast<uptr_t>(regs[REG_RAX]));
+  writeRegister(sink, "  rbx", static_cast<uptr_t>(regs[REG_RBX]));
+  writeRegister(sink, "  rcx", static_cast<uptr_t>(regs[REG_RCX]));
+  writeRegister(sink, "\nrdx", static_cast<uptr_t>(regs[REG_RDX]));
+  writeRegister(sink, "  rsi", static_cast<uptr_t>(regs[REG_RSI]));
+  writeRegister(sink, "  rdi", static_cast<uptr_t>(regs[REG_RDI]));
+  sink.write("\n");
+#elif defined(__aarch64__)
+  const auto& mcontext {context->uc_mcontext};
+  writeRegister(sink, "pc", mcontext.pc);
+  writeRegister(sink, "  sp", mcontext.sp);
+  writeRegister(sink, "  x29", mcontext.regs[29]);
+  writeRegister(sink, "\nx30", mcontext.regs[30]);
+  writeRegister(sink, "  x0", mcontext.regs[0]);
+  writeRegister(sink, "  x1", mcontext.regs[1]);
+  sink.write("\n");
+#else
+  static_cast<void>(sink);
+  static_cast<void>(context);
+#endif
+}
+
+uptr_t stackPointer(const ucontext_t* context) noexcept {
+#if defined(__x86_64__)
+  return static_cast<uptr_t>(context->uc_mcontext.gregs[REG_RSP]);
+#elif defined(__aarch64__)
+  return context->uc_mcontext.sp;
+#else
+  static_cast<void>(context);
+  return 0;
+#endif
+}
+
+// Copy size bytes at address, all in the same page, to buffer; false if they
+// can't be read
+bool readChunk(const uptr_t address, const uptr_t size, byte_t* buffer) noexcept {
+  iovec local {buffer, size};
+  iovec remote {reinterpret_cast<void*>(address), size};
+  const ssize_t read {::process_vm_readv(::getpid(), &local, 1, &remote, 1, 0)};
+  if (read >= 0) {
+    return static_cast<uptr_t>(read) == size;
+  }
+  if ((EFAULT == errno) || (probePipe[0] < 0)) {
+    return false;
+  }
+
+  // process_vm_readv() not permitted: the kernel copies the bytes into the
+  // pipe, or fails with EFAULT, then they're read back
+  if (::write(probePipe[1], reinterpret_cast<const void*>(address), size) != static_cast<ssize_t>(size)) {
+    return false;
+  }
+  return ::read(probePipe[0], buffer, size) == static_cast<ssize_t>(size);
+}
+
+void renderCrashWindow(Sink& sink, const std::string_view title, const DumpWindow& window) noexcept {
+  sink.write(title);
+  DumpRenderer renderer {window, crashDumpOptions, {}, sink};
+
+  byte_t buffer[readChunkSize];
+  const uptr_t end {window.start() + window.length()};
+  for (uptr_t address {window.start()}; (address < end) && (address >= window.start());) {
+    const uptr_t next {std::min((address / readChunkSize + 1) * readChunkSize, end)};
+    if (readChunk(address, next - address, buffer)) {
+      renderer.render(buffer, next - address);
+    } else {
+      renderer.renderUnreadable(next - address);
+    }
+    address = next;
+  }
+  renderer.finish();
+}
+
+void crashHandler(const int signal, siginfo_t* info, void* ucontext) {
+  const int savedErrno {errno};
+  if (crashing.exchange(true)) {
+    // another thread is dumping: the process dies when it's done
+    for (;;) {
+      ::pause();
+    }
+  }
+  const auto* context {static_cast<const ucontext_t*>(ucontext)};
+  const auto faultAddress {reinterpret_cast<uptr_t>(info->si_addr)};
+  {
+    FdSink sink {crashOptions.fd};
+
+    sink.write("\n[memDump:crash]--------------------------------------------------------\n");
+    sink.write(signalName(signal));
+    sink.write(" (");
+    writeDecimal(sink, static_cast<std::uint64_t>(signal));
+    sink.write(") ");
+    sink.write(codeName(signal, info->si_code));
+    if ((SIGSEGV == signal) || (SIGBUS == signal)) {
+      sink.write(" at ");
+      writeHex(sink, faultAddress);
+    }
+    sink.write(" in thread ");
+    writeDecimal(sink, static_cast<std::uint64_t>(::syscall(SYS_gettid)));
+    sink.write("\n");
+    writeRegisters(sink, context);
+
+    if ((SIGSEGV == signal) || (SIGBUS == signal)) {
+      const uptr_t pre {std::min(crashOptions.faultContextSize, faultAddress)};
+      renderCrashWindow(sink, "\nMemory around the faulting address:\n",
+                        DumpWindow {faultAddress, 1, pre, crashOptions.faultContextSize});
+    }
+    const uptr_t sp {stackPointer(context)};
+    if (0 != sp) {
+      const uptr_t pre {std::min(crashOptions.stackContextSize, sp)};
+      renderCrashWindow(sink, "\nStack from the stack pointer:\n",
+                        DumpWindow {sp, sizeof(uptr_t), pre, crashOptions.stackSize});
+    }
+  }
+
+  // the handler was reset on entry: die of the signal, with a core dump if
+  // enabled, when the handler returns
+  ::signal(signal, SIG_DFL);
+  ::raise(signal);
+  errno = savedErrno;
+}
+}  // namespace
+
+bool installCrashAltStack() noexcept {
+  if (nullptr != altStack.memory) {
+    return true;
+  }
+  void* const memory {::mmap(nullptr, altStackSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)};
+  if (MAP_FAILED == memory) {
+    std::cerr << "memDump::installCrashAltStack: mmap: " << std::strerror(errno) << "\n";
+    return false;
+  }
+  stack_t stack {};
+  stack.ss_sp = memory;
+  stack.ss_size = altStackSize;
+  if (::sigaltstack(&stack, nullptr) < 0) {
+    std::cerr << "memDump::installCrashAltStack: sigaltstack: " << std::strerror(errno) << "\n";
+    ::munmap(memory, altStackSize);
+    return false;
+  }
+  altStack.memory = memory;
+  return true;
+}
+
+bool installCrashHandler(const CrashHandlerOptions& options) noexcept {
+  return installCrashHandler(options, currentDumpOptions());
+}
+
+bool installCrashHandler(const CrashHandlerOptions& crash, const DumpOptions& options) noexcept {
+  crashOptions = crash;
+  crashDumpOptions = options;
+  if ((probePipe[0] < 0) && (::pipe2(probePipe, O_CLOEXEC | O_NONBLOCK) < 0)) {
+    probePipe[0] = probePipe[1] = -1;  // only process_vm_readv() then
+  }
+  if (!installCrashAltStack()) {
+    return false;
+  }
+
+  struct sigaction action {};
+  action.sa_sigaction = crashHandler;
+  action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESETHAND;
+  sigemptyset(&action.sa_mask);
+  for (std::size_t i {0}; i < signalCount; ++i) {
+    // keep the handlers replaced the first time, not this one
+    if (::sigaction(crashSignals[i], &action, installed ? nullptr : &previousActions[i]) < 0) {
+      std::cerr << "memDump::installCrashHandler: sigaction: " << std::strerror(errno) << "\n";
+      return false;
+    }
+  }
+  installed = true;
+  return true;
+}
+
+void uninstallCrashHandler() noexcept {
+  if (!installed) {
+    return;
+  }
+  for (std::size_t i {0}; i < signalCount; ++i) {
+    ::sigaction(crashSignals[i], &previousActions[i], nullptr);
+  }
+  installed = false;
+}
+}  // namespace memDump
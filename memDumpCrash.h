@@ -0,0 +1,40 @@
+//
+// memDumpCrash.h
+//
+// A handler of SIGSEGV, SIGBUS and SIGABRT dumping the memory around the
+// faulting address and the stack pointer, in the layout of dumpMemory(),
+// before the process dies of the signal
+//
+#pragma once
+
+#include "memDump.h"
+#include <unistd.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+struct CrashHandlerOptions {
+  int fd {STDERR_FILENO};           // where the dumps are written
+  uptr_t faultContextSize {64};     // bytes dumped before and after the faulting address
+  uptr_t stackContextSize {32};     // bytes dumped below the stack pointer
+  uptr_t stackSize {256};           // bytes dumped from the stack pointer up
+};
+
+// Install the handler of SIGSEGV, SIGBUS and SIGABRT, with the layout of
+// options. The handler is async-signal-safe: it formats into buffers on its
+// stack, reads the memory with process_vm_readv() so that unreadable pages
+// are printed as ??, writes with write(2), then re-raises the signal with
+// its default action. It runs on an alternate signal stack, so that stack
+// overflows are reported too, in the thread that installed it; the other
+// threads get their own with installCrashAltStack(). Return false, with a
+// message on std::cerr, if the handler can't be installed
+bool installCrashHandler(const CrashHandlerOptions& crashOptions, const DumpOptions& options) noexcept;
+
+bool installCrashHandler(const CrashHandlerOptions& crashOptions = {}) noexcept;
+
+// give the calling thread an alternate signal stack for the handler, mapped
+// now and unmapped when the thread exits
+bool installCrashAltStack() noexcept;
+
+// restore the handlers replaced by installCrashHandler()
+void uninstallCrashHandler() noexcept;
+}  // namespace memDump
@@ -0,0 +1,95 @@
+//
+// memDumpFile.cpp
+//
+#include "memDumpFile.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+namespace {
+// bytes of the file mapped at a time
+constexpr std::uint64_t mapWindowSize {64UL << 20};
+
+bool fail(const char* path, const char* what) noexcept {
+  std::cerr << "memDump::dumpFile: " << path << ": " << what << ": " << std::strerror(errno) << "\n";
+  return false;
+}
+}  // namespace
+
+bool dumpFile(const char* path,
+              const std::uint64_t offset,
+              const std::uint64_t length,
+              std::ostream& os) noexcept {
+  return dumpFile(path, offset, length, currentDumpOptions(), os);
+}
+
+bool dumpFile(const char* path,
+              const std::uint64_t offset,
+              const std::uint64_t length,
+              const DumpOptions& options,
+              std::ostream& os) noexcept {
+  const int fd {::open(path, O_RDONLY | O_CLOEXEC)};
+  if (fd < 0) {
+    return fail(path, "open");
+  }
+
+  struct stat st {};
+  if (::fstat(fd, &st) < 0) {
+    const bool result {fail(path, "fstat")};
+    ::close(fd);
+    return result;
+  }
+  const auto fileSize {static_cast<std::uint64_t>(st.st_size)};
+  if (offset >= fileSize) {
+    std::cerr << "memDump::dumpFile: " << path << ": offset " << offset
+              << " beyond the end of the file (" << fileSize << " bytes)\n";
+    ::close(fd);
+    return false;
+  }
+  const std::uint64_t size {(0 == length) ? fileSize - offset : std::min(length, fileSize - offset)};
+
+  // the file offsets are the addresses of the dump; the context can't go
+  // before the start or past the end of the file
+  DumpWindow window {dumpWindow(reinterpret_cast<const void*>(offset), size, options)};
+  window.preBufferSize = std::min<uptr_t>(window.preBufferSize, offset);
+  window.postBufferSize = std::min<uptr_t>(window.postBufferSize, fileSize - offset - size);
+
+  os << "[memDump:dumpFile] " << path << ": " << std::dec << size << " bytes at offset "
+     << offset << " of " << fileSize << "\n";
+
+  ::posix_fadvise(fd, static_cast<off_t>(window.start()), static_cast<off_t>(window.length()),
+                  POSIX_FADV_SEQUENTIAL);
+
+  DumpRenderer renderer {window, options, "", os};
+  const auto pageSize {static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE))};
+  const std::uint64_t end {window.start() + window.length()};
+  bool result {true};
+
+  for (std::uint64_t position {window.start()}; position < end; ) {
+    // map page-aligned windows of the file, one at a time
+    const std::uint64_t mapOffset {position - position % pageSize};
+    const std::uint64_t mapLength {std::min(mapWindowSize, end - mapOffset)};
+    void* map {::mmap(nullptr, mapLength, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(mapOffset))};
+    if (MAP_FAILED == map) {
+      result = fail(path, "mmap");
+      break;
+    }
+    ::madvise(map, mapLength, MADV_SEQUENTIAL);
+
+    const std::uint64_t count {mapOffset + mapLength - position};
+    renderer.render(static_cast<const byte_t*>(map) + (position - mapOffset), count);
+    position += count;
+
+    // the pages already rendered are not needed anymore
+    ::munmap(map, mapLength);
+  }
+  renderer.finish();
+  ::close(fd);
+  return result;
+}
+}  // namespace memDump
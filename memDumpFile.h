@@ -0,0 +1,29 @@
+//
+// memDumpFile.h
+//
+// Dumps of files, e.g. binary or ELF core files, in the same layout as the
+// dumps of memory, with the file offsets as addresses
+//
+#pragma once
+
+#include "memDump.h"
+#include <cstdint>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+// Dump length bytes at offset in the file at path, with the context of
+// options; length 0 means through the end of the file. The context is clipped
+// to the file. The file is mapped a window at a time, with sequential access
+// hints, so that memory use is constant whatever the size of the file.
+// Return false, with a message on std::cerr, if the file can't be dumped
+bool dumpFile(const char* path,
+              const std::uint64_t offset,
+              const std::uint64_t length,
+              const DumpOptions& options,
+              std::ostream& os = std::cout) noexcept;
+
+bool dumpFile(const char* path,
+              const std::uint64_t offset,
+              const std::uint64_t length,
+              std::ostream& os = std::cout) noexcept;
+}  // namespace memDump
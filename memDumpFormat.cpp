@@ -0,0 +1,293 @@
+//
+// memDumpFormat.cpp
+//
+#include "memDumpFormat.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+namespace {
+// two lower-case hex digits for every byte value, as xxd prints them
+constexpr std::array<char, 512> hexPairs {[] {
+  constexpr char digits[] {"0123456789abcdef"};
+  std::array<char, 512> table {};
+  for (std::size_t v {0}; v < 256; ++v) {
+    table[2 * v]     = digits[v >> 4];
+    table[2 * v + 1] = digits[v & 0xF];
+  }
+  return table;
+}()};
+
+// the character xxd prints for every byte value
+constexpr std::array<char, 256> asciiChars {[] {
+  std::array<char, 256> table {};
+  for (std::size_t v {0}; v < 256; ++v) {
+    table[v] = ((v >= 0x20) && (v < 0x7F)) ? static_cast<char>(v) : '.';
+  }
+  return table;
+}()};
+
+// rendered in place of the unreadable bytes
+constexpr byte_t zeros[4096] {};
+
+void writeDecimal(Sink& sink, std::uint64_t value) noexcept {
+  char digits[20];
+  std::size_t count {sizeof(digits)};
+  do {
+    digits[--count] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  sink.write(digits + count, sizeof(digits) - count);
+}
+
+// "0x" and the lower-case hex digits of address, as a pointer is printed
+void writeAddress(Sink& sink, std::uint64_t address) noexcept {
+  char digits[18];
+  std::size_t count {sizeof(digits)};
+  do {
+    digits[--count] = hexPairs[2 * (address & 0xF) + 1];
+    address >>= 4;
+  } while (address > 0);
+  digits[--count] = 'x';
+  digits[--count] = '0';
+  sink.write(digits + count, sizeof(digits) - count);
+}
+
+// name as the contents of a JSON string
+void writeJsonString(Sink& sink, const std::string_view name) noexcept {
+  for (const char c : name) {
+    if (('"' == c) || ('\\' == c)) {
+      const char escaped[] {'\\', c};
+      sink.write(escaped, sizeof(escaped));
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      const char escaped[] {'\\', 'u', '0', '0', hexPairs[2 * static_cast<unsigned char>(c)], hexPairs[2 * static_cast<unsigned char>(c) + 1]};
+      sink.write(escaped, sizeof(escaped));
+    } else {
+      sink.write(&c, 1);
+    }
+  }
+}
+}  // namespace
+
+XxdFormat::XxdFormat(const DumpWindow&,
+                     const DumpOptions&,
+                     const std::string_view,
+                     Sink& sink) noexcept :
+sink_(sink)
+{}
+
+void XxdFormat::render(const byte_t* bytes, uptr_t count) noexcept {
+  while (count > 0) {
+    if (0 == count_) {
+      // a new line: its offset in 8 hex digits, at least, and empty columns
+      uptr_t offset {offset_};
+      for (std::size_t i {hexColumn - 2}; i > 0; --i, offset >>= 4) {
+        line_[i - 1] = hexPairs[2 * (offset & 0xF) + 1];
+      }
+      line_[hexColumn - 2] = ':';
+      std::memset(line_ + hexColumn - 1, ' ', asciiColumn - hexColumn + 1);
+    }
+    // the lines end at the offsets multiple of the columns
+    const uptr_t n {std::min(count, columns - (offset_ - count_) % columns - count_)};
+    for (uptr_t i {count_}; i < count_ + n; ++i, ++bytes) {
+      std::memcpy(line_ + hexColumn + 2 * i + i / 2, &hexPairs[2 * *bytes], 2);
+      line_[asciiColumn + i] = asciiChars[*bytes];
+    }
+    count_ += n;
+    offset_ += n;
+    count -= n;
+    if (0 == offset_ % columns) {
+      flushLine();
+    }
+  }
+}
+
+void XxdFormat::renderUnreadable(const uptr_t count) noexcept {
+  // xxd -r leaves holes for the offsets skipped
+  flushLine();
+  offset_ += count;
+}
+
+void XxdFormat::finish() noexcept {
+  flushLine();
+  sink_.flush();
+}
+
+void XxdFormat::flushLine() noexcept {
+  if (0 == count_) {
+    return;
+  }
+  // the line holds the 8 low hex digits of the offset: the others, if any,
+  // go before them
+  char high[8];
+  std::size_t digits {0};
+  for (uptr_t offset {(offset_ - count_) >> 32}; offset > 0; offset >>= 4) {
+    high[sizeof(high) - ++digits] = hexPairs[2 * (offset & 0xF) + 1];
+  }
+  if (digits > 0) {
+    sink_.write(high + sizeof(high) - digits, digits);
+  }
+  line_[asciiColumn + count_] = '\n';
+  sink_.write(line_, asciiColumn + count_ + 1);
+  count_ = 0;
+}
+
+CArrayFormat::CArrayFormat(const DumpWindow& window,
+                           const DumpOptions& options,
+                           const std::string_view demangledTypeName,
+                           Sink& sink) noexcept :
+sink_(sink),
+rowWidth_(options.validRowWidth())
+{
+  sink_.write("// ");
+  if (!demangledTypeName.empty()) {
+    sink_.write(demangledTypeName);
+    sink_.write(" of ");
+  }
+  writeDecimal(sink_, window.size);
+  sink_.write(" bytes at ");
+  writeAddress(sink_, window.address);
+  sink_.write(", with ");
+  writeDecimal(sink_, window.preBufferSize);
+  sink_.write(" bytes of context before and ");
+  writeDecimal(sink_, window.postBufferSize);
+  sink_.write(" after\nconst unsigned char memory[");
+  writeDecimal(sink_, window.length());
+  sink_.write("] = {\n");
+}
+
+void CArrayFormat::render(const byte_t* bytes, uptr_t count) noexcept {
+  while (count > 0) {
+    const uptr_t n {std::min(count, rowWidth_ - count_)};
+    // "  0x41, 0x42, ..."
+    char* out {row_ + 2 + 6 * count_};
+    for (const byte_t* end {bytes + n}; bytes < end; ++bytes, out += 6) {
+      out[0] = '0';
+      out[1] = 'x';
+      std::memcpy(out + 2, &hexPairs[2 * *bytes], 2);
+      out[4] = ',';
+      out[5] = ' ';
+    }
+    count_ += n;
+    offset_ += n;
+    count -= n;
+    if (rowWidth_ == count_) {
+      flushRow();
+    }
+  }
+}
+
+void CArrayFormat::renderUnreadable(uptr_t count) noexcept {
+  flushRow();
+  sink_.write("  // ");
+  writeDecimal(sink_, count);
+  sink_.write(" unreadable bytes at offset ");
+  writeDecimal(sink_, offset_);
+  sink_.write(", as 0\n");
+  for (; count > 0; count -= std::min<uptr_t>(count, sizeof(zeros))) {
+    render(zeros, std::min<uptr_t>(count, sizeof(zeros)));
+  }
+}
+
+void CArrayFormat::finish() noexcept {
+  flushRow();
+  sink_.write("};\n");
+  sink_.flush();
+}
+
+void CArrayFormat::flushRow() noexcept {
+  if (0 == count_) {
+    return;
+  }
+  row_[0] = ' ';
+  row_[1] = ' ';
+  row_[2 + 6 * count_ - 1] = '\n';
+  sink_.write(row_, 2 + 6 * count_);
+  count_ = 0;
+}
+
+JsonFormat::JsonFormat(const DumpWindow& window,
+                       const DumpOptions&,
+                       const std::string_view demangledTypeName,
+                       Sink& sink) noexcept :
+sink_(sink)
+{
+  sink_.write("{\"type\":\"");
+  writeJsonString(sink_, demangledTypeName);
+  sink_.write("\",\"address\":\"");
+  writeAddress(sink_, window.address);
+  sink_.write("\",\"size\":");
+  writeDecimal(sink_, window.size);
+  sink_.write(",\"start\":\"");
+  writeAddress(sink_, window.start());
+  sink_.write("\",\"length\":");
+  writeDecimal(sink_, window.length());
+  sink_.write(",\"highlight\":{\"offset\":");
+  writeDecimal(sink_, window.preBufferSize);
+  sink_.write(",\"size\":");
+  writeDecimal(sink_, window.size);
+  sink_.write("},\"runs\":[");
+}
+
+void JsonFormat::render(const byte_t* bytes, uptr_t count) noexcept {
+  if (!readableRun_) {
+    closeRun();
+    openRun("bytes\":\"");
+    readableRun_ = true;
+  }
+  offset_ += count;
+  // the hex digits of up to 256 bytes at a time
+  char hex[512];
+  while (count > 0) {
+    const uptr_t n {std::min<uptr_t>(count, sizeof(hex) / 2)};
+    for (uptr_t i {0}; i < n; ++i) {
+      std::memcpy(hex + 2 * i, &hexPairs[2 * bytes[i]], 2);
+    }
+    sink_.write(hex, 2 * n);
+    bytes += n;
+    count -= n;
+  }
+}
+
+void JsonFormat::renderUnreadable(const uptr_t count) noexcept {
+  if (!unreadableRun_) {
+    closeRun();
+    openRun("unreadable\":");
+    unreadableRun_ = true;
+  }
+  offset_ += count;
+}
+
+void JsonFormat::finish() noexcept {
+  closeRun();
+  sink_.write("]}\n");
+  sink_.flush();
+}
+
+void JsonFormat::openRun(const std::string_view kind) noexcept {
+  sink_.write(firstRun_ ? "{\"offset\":" : ",{\"offset\":");
+  writeDecimal(sink_, offset_);
+  sink_.write(",\"");
+  sink_.write(kind);
+  runOffset_ = offset_;
+  firstRun_ = false;
+}
+
+void JsonFormat::closeRun() noexcept {
+  if (readableRun_) {
+    sink_.write("\"}");
+  } else if (unreadableRun_) {
+    writeDecimal(sink_, offset_ - runOffset_);
+    sink_.write("}");
+  }
+  readableRun_ = false;
+  unreadableRun_ = false;
+}
+
+void RawFormat::renderUnreadable(uptr_t count) noexcept {
+  for (; count > 0; count -= std::min<uptr_t>(count, sizeof(zeros))) {
+    sink_.write(reinterpret_cast<const char*>(zeros), std::min<uptr_t>(count, sizeof(zeros)));
+  }
+}
+}  // namespace memDump
@@ -0,0 +1,218 @@
+//
+// memDumpFormat.h
+//
+// Formats of dumps chosen at compile time: the colored layout of
+// dumpMemory(), xxd, C arrays, JSON and raw bytes. Each format is a class
+// with its own loop over the bytes, doing only the work its output needs
+//
+#pragma once
+
+#include "memDump.h"
+#include "memDumpMaps.h"
+#include <algorithm>
+#include <string_view>
+#include <unistd.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+// A format renders the bytes of a window passed in order, like DumpRenderer:
+//   Format(const DumpWindow&, const DumpOptions&, std::string_view demangledTypeName, Sink&)
+//   void render(const byte_t* bytes, uptr_t count)
+//   void renderUnreadable(uptr_t count)
+//   void finish()
+template <typename Format>
+concept DumpFormat = requires(Format format, const byte_t* bytes, uptr_t count) {
+  format.render(bytes, count);
+  format.renderUnreadable(count);
+  format.finish();
+};
+
+// The layout of dumpMemory(), in colors if enabled
+class ColoredFormat final {
+public:
+  ColoredFormat(const DumpWindow& window,
+                const DumpOptions& options,
+                const std::string_view demangledTypeName,
+                Sink& sink) noexcept :
+  renderer_(window, options, demangledTypeName, sink)
+  {}
+
+  void render(const byte_t* bytes, const uptr_t count) noexcept {
+    renderer_.render(bytes, count);
+  }
+
+  void renderUnreadable(const uptr_t count) noexcept {
+    renderer_.renderUnreadable(count);
+  }
+
+  void finish() noexcept {
+    renderer_.finish();
+  }
+
+private:
+  DumpRenderer renderer_;
+};
+
+// The layout of xxd, with the offsets from the start of the window: xxd -r
+// rebuilds the window, with zeros for the unreadable bytes followed by
+// readable ones
+class XxdFormat final {
+public:
+  XxdFormat(const DumpWindow& window,
+            const DumpOptions& options,
+            const std::string_view demangledTypeName,
+            Sink& sink) noexcept;
+
+  void render(const byte_t* bytes, uptr_t count) noexcept;
+  void renderUnreadable(const uptr_t count) noexcept;
+  void finish() noexcept;
+
+private:
+  static constexpr uptr_t columns {16};
+  // offset, hex digits in groups of 2 bytes, ascii
+  static constexpr std::size_t hexColumn {10};
+  static constexpr std::size_t asciiColumn {hexColumn + 5 * columns / 2 + 1};
+  static constexpr std::size_t lineSize {asciiColumn + columns + 1};
+
+  void flushLine() noexcept;
+
+  Sink& sink_;
+  uptr_t offset_ {0};  // of the next byte
+  uptr_t count_ {0};   // bytes in the line
+  char line_[lineSize];
+};
+
+// A C/C++ array initialized with the bytes of the window, rows of the row
+// width of the options; the unreadable bytes are 0, with a comment
+class CArrayFormat final {
+public:
+  CArrayFormat(const DumpWindow& window,
+               const DumpOptions& options,
+               const std::string_view demangledTypeName,
+               Sink& sink) noexcept;
+
+  void render(const byte_t* bytes, uptr_t count) noexcept;
+  void renderUnreadable(uptr_t count) noexcept;
+  void finish() noexcept;
+
+private:
+  void flushRow() noexcept;
+
+  Sink& sink_;
+  const uptr_t rowWidth_;
+  uptr_t offset_ {0};
+  uptr_t count_ {0};  // bytes in the row
+  char row_[2 + DumpOptions::maxRowWidth * 6 + 1];
+};
+
+// A JSON object: the type name, the address and size of the data, the window
+// and the offset of the data in it, then the runs of the window: the
+// readable ones with their bytes in hex, the others with their size
+//   {"type":"long","address":"0x7ffd5c3a0f18","size":8,
+//    "start":"0x7ffd5c3a0f00","length":48,"highlight":{"offset":24,"size":8},
+//    "runs":[{"offset":0,"bytes":"0807..."}]}
+class JsonFormat final {
+public:
+  JsonFormat(const DumpWindow& window,
+             const DumpOptions& options,
+             const std::string_view demangledTypeName,
+             Sink& sink) noexcept;
+
+  void render(const byte_t* bytes, uptr_t count) noexcept;
+  void renderUnreadable(const uptr_t count) noexcept;
+  void finish() noexcept;
+
+private:
+  // end the run being rendered, if any
+  void closeRun() noexcept;
+  void openRun(const std::string_view kind) noexcept;
+
+  Sink& sink_;
+  uptr_t offset_ {0};
+  uptr_t runOffset_ {0};
+  bool readableRun_ {false};
+  bool unreadableRun_ {false};
+  bool firstRun_ {true};
+};
+
+// The bytes of the window as they are, the unreadable ones as 0
+class RawFormat final {
+public:
+  RawFormat(const DumpWindow&,
+            const DumpOptions&,
+            const std::string_view,
+            Sink& sink) noexcept :
+  sink_(sink)
+  {}
+
+  void render(const byte_t* bytes, const uptr_t count) noexcept {
+    sink_.write(reinterpret_cast<const char*>(bytes), count);
+  }
+
+  void renderUnreadable(uptr_t count) noexcept;
+
+  void finish() noexcept {
+    sink_.flush();
+  }
+
+private:
+  Sink& sink_;
+};
+
+// Render the window in format, reading the memory at the addresses shown;
+// with safeRead the memory is copied a page at a time with copyMemory(),
+// without allocating, and the pages that can't be read are rendered as
+// unreadable
+template <DumpFormat Format>
+void renderMemoryAs(Format& format, const DumpWindow& window, const bool safeRead) noexcept {
+  const uptr_t end {window.start() + window.length()};
+  if (!safeRead) {
+    format.render(reinterpret_cast<const byte_t*>(window.start()), window.length());
+    return;
+  }
+  static const auto page {static_cast<uptr_t>(::sysconf(_SC_PAGESIZE))};
+  byte_t buffer[4096];
+  for (uptr_t address {window.start()}; address < end;) {
+    const uptr_t count {std::min({end - address, (address / page + 1) * page - address, uptr_t {sizeof(buffer)}})};
+    const std::size_t copied {copyMemory(address, count, buffer)};
+    if (copied > 0) {
+      format.render(buffer, copied);
+    }
+    if (copied < count) {
+      format.renderUnreadable(count - copied);
+    }
+    address += count;
+  }
+}
+
+// Dump size bytes at ptr, with the context of options, in Format: e.g.
+//   memDump::dumpMemoryAs<memDump::JsonFormat>(&v, sizeof(v), options, "long", sink);
+template <DumpFormat Format>
+void dumpMemoryAs(const void* ptr,
+                  const std::size_t size,
+                  const DumpOptions& options,
+                  const std::string_view demangledTypeName,
+                  Sink& sink) noexcept {
+  const DumpWindow window {dumpWindow(ptr, size, options)};
+  Format format {window, options, demangledTypeName, sink};
+
+  renderMemoryAs(format, window, options.safeRead);
+  format.finish();
+}
+
+template <DumpFormat Format>
+void dumpMemoryAs(const void* ptr,
+                  const std::size_t size,
+                  const DumpOptions& options,
+                  const std::string_view demangledTypeName = {},
+                  std::ostream& os = std::cout) noexcept {
+  OstreamSink sink {os};
+
+  dumpMemoryAs<Format>(ptr, size, options, demangledTypeName, sink);
+}
+
+template <DumpFormat Format, typename T>
+void dumpMemoryAs(const T& var, std::ostream& os = std::cout) noexcept {
+  dumpMemoryAs<Format>(&var, sizeof(var), currentDumpOptions(), demangle::typeName<T>(), os);
+}
+}  // namespace memDump
@@ -0,0 +1,200 @@
+//
+// memDumpGraph.cpp
+//
+#include "memDumpGraph.h"
+#include "memDumpMaps.h"
+#include "memDumpRegistry.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+namespace {
+struct Block {
+  uptr_t address;
+  std::size_t size;
+  unsigned depth;
+  std::size_t parent;  // the block linking to it first
+  uptr_t linkOffset;   // of the link in the parent
+  bool verified;       // not possibly a freed chunk of the heap, nor reached from one
+};
+
+// a word of a block pointing into another block
+struct Link {
+  uptr_t offset;  // of the word in its block
+  std::size_t block;
+  uptr_t target;  // the address pointed to, in the block
+};
+
+// memory malloc() hands out: the heap, or anonymous mappings
+bool isHeap(const MemoryRegion& region) noexcept {
+  return region.name.empty() || ("[heap]" == region.name);
+}
+
+void printLinks(const std::vector<Link>& links, const std::vector<Block>& blocks, std::ostream& os) {
+  os << std::hex;
+  for (const Link& link : links) {
+    os << "  +0x" << link.offset << " -> block " << std::dec << link.block << std::hex << " at "
+       << reinterpret_cast<const void*>(blocks[link.block].address);
+    if (blocks[link.block].address != link.target) {
+      os << " +0x" << (link.target - blocks[link.block].address);
+    }
+    os << "\n";
+  }
+  os << std::dec;
+}
+}  // namespace
+
+void dumpMemoryGraph(const void* ptr,
+                     const std::size_t size,
+                     const DumpOptions& options,
+                     const GraphOptions& graphOptions,
+                     const std::string_view demangledTypeName,
+                     std::ostream& os) noexcept {
+  try {
+    // one snapshot of the mappings for the whole graph: the heap may have
+    // grown since the last dump
+    MemoryMap& map {selfMemoryMap()};
+    map.refresh();
+    const auto regions {map.regions()};
+    const auto root {reinterpret_cast<uptr_t>(ptr)};
+
+    std::vector<Block> blocks {Block {root, size, 0, 0, 0, true}};
+    // the blocks by address, so that each one is dumped once whatever the
+    // number of links to it, cycles included
+    std::unordered_map<uptr_t, std::size_t> visited {{root, 0}};
+    std::vector<Link> links;
+    std::vector<byte_t> contents;
+    std::size_t bytes {size};
+    std::size_t overBudget {0};
+    std::size_t unverified {0};
+
+    os << "[memDump:graph] " << (demangledTypeName.empty() ? std::string_view {"memory"} : demangledTypeName)
+       << " at " << ptr << ", pointers followed " << std::dec << graphOptions.maxDepth
+       << " deep, up to " << graphOptions.maxBytes << " bytes\n";
+
+    for (std::size_t b {0}; b < blocks.size(); ++b) {
+      const Block block {blocks[b]};  // blocks grows below
+      os << "\nblock " << std::dec << b;
+      if (b > 0) {
+        os << ", depth " << block.depth << ", linked from block " << block.parent << " +0x" << std::hex
+           << block.linkOffset << std::dec;
+      }
+      if (!block.verified) {
+        os << ", unverified: may be freed heap memory";
+        ++unverified;
+      }
+      os << "\n";
+      dumpMemory(reinterpret_cast<const void*>(block.address), block.size, options,
+                 (0 == b) ? demangledTypeName : std::string_view {}, os);
+
+      // the root is the only block not known to be in a readable mapping
+      if ((block.depth >= graphOptions.maxDepth) || !regions ||
+          ((0 == b) && options.safeRead && !map.isReadable(block.address, block.size))) {
+        continue;
+      }
+
+      links.clear();
+      // the words are read from a copy: the mappings are a snapshot
+      contents.resize(block.size);
+      const uptr_t end {block.address + copyMemory(block.address, block.size, contents.data())};
+      for (uptr_t word {(block.address + alignof(void*) - 1) / alignof(void*) * alignof(void*)};
+           word + sizeof(uptr_t) <= end;
+           word += alignof(void*)) {
+        uptr_t target {};
+        std::memcpy(&target, contents.data() + (word - block.address), sizeof(target));
+        if ((target >= block.address) && (target < block.address + block.size)) {
+          continue;  // e.g. the buffer of a short string, inside its object
+        }
+        const MemoryRegion* region {findMemoryRegion(*regions, target)};
+        if ((nullptr == region) || !isScannable(*region) || (!region->writable && !graphOptions.followReadOnly)) {
+          continue;
+        }
+
+        Allocation allocation {target, std::min<uptr_t>(graphOptions.blockSize, region->end - target), {}};
+        const bool registered {allocationRegistryEnabled &&
+                               findAllocation(reinterpret_cast<const void*>(target), allocation)};
+        if (registered) {
+          allocation.size = std::min<uptr_t>(allocation.size, region->end - allocation.address);
+        }
+
+        auto found {visited.find(allocation.address)};
+        if (visited.end() == found) {
+          // a target inside a block found before is a link to it, e.g. the
+          // object inside the control block of a make_shared
+          const auto inside {std::find_if(blocks.begin(), blocks.end(), [&](const Block& other) {
+            return (target >= other.address) && (target < other.address + other.size);
+          })};
+          if (blocks.end() != inside) {
+            links.push_back(Link {word - block.address, static_cast<std::size_t>(inside - blocks.begin()), target});
+            continue;
+          }
+
+          // A block of blockSize bytes, not an allocation, ends where the
+          // next block starts, e.g. the control block of a make_shared found
+          // after its object: if that one isn't dumped yet, and isn't an
+          // allocation either, it's extended back to the target instead, so
+          // that no byte is dumped twice
+          if (!registered) {
+            auto next {blocks.end()};
+            for (auto other {blocks.begin()}; blocks.end() != other; ++other) {
+              if ((other->address > target) && (other->address < target + allocation.size) &&
+                  ((blocks.end() == next) || (other->address < next->address))) {
+                next = other;
+              }
+            }
+            if ((blocks.end() != next) && !allocationRegistryEnabled &&
+                (static_cast<std::size_t>(next - blocks.begin()) > b)) {
+              if (bytes + (next->address - target) > graphOptions.maxBytes) {
+                ++overBudget;
+                continue;
+              }
+              bytes += next->address - target;
+              const auto index {static_cast<std::size_t>(next - blocks.begin())};
+              visited.erase(next->address);
+              visited.emplace(target, index);
+              next->size += next->address - target;
+              next->address = target;
+              links.push_back(Link {word - block.address, index, target});
+              continue;
+            }
+            if (blocks.end() != next) {
+              allocation.size = next->address - target;
+            }
+          }
+
+          if (bytes + allocation.size > graphOptions.maxBytes) {
+            ++overBudget;
+            continue;
+          }
+          bytes += allocation.size;
+          // without the registry nothing tells a live allocation from a freed
+          // chunk of the heap, whose stale words would be followed as links
+          const bool verified {block.verified && (registered || !isHeap(*region))};
+          found = visited.emplace(allocation.address, blocks.size()).first;
+          blocks.push_back(Block {allocation.address, allocation.size, block.depth + 1, b, word - block.address,
+                                  verified});
+        }
+        links.push_back(Link {word - block.address, found->second, target});
+      }
+      if (!links.empty()) {
+        os << "links of block " << std::dec << b << ":\n";
+        printLinks(links, blocks, os);
+      }
+    }
+
+    os << "\n" << std::dec << blocks.size() << " blocks, " << bytes << " bytes";
+    if (overBudget > 0) {
+      os << "; " << overBudget << ((1 == overBudget) ? " pointer" : " pointers") << " not followed, over the budget";
+    }
+    if (unverified > 0) {
+      os << "; " << unverified << ((1 == unverified) ? " block" : " blocks")
+         << " unverified, in the heap but not known allocations";
+    }
+    os << "\n";
+  } catch (...) {
+    std::cerr << "memDump::dumpMemoryGraph: out of memory\n";
+  }
+}
+}  // namespace memDump
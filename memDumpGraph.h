@@ -0,0 +1,41 @@
+//
+// memDumpGraph.h
+//
+// Dumps of the memory reachable from an object: the aligned words pointing
+// into the mappings of the process are followed, so that one call shows the
+// control block behind a shared_ptr or the heap buffer of a long string
+//
+#pragma once
+
+#include "memDump.h"
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+struct GraphOptions {
+  unsigned maxDepth {2};       // pointers followed from the root, then from the blocks found
+  std::size_t maxBytes {4096}; // bytes dumped, the root included
+  std::size_t blockSize {64};  // bytes dumped at a target, without the allocation registry
+  bool followReadOnly {false}; // follow the pointers to read-only mappings too, e.g. vtables
+};
+
+// Dump the size bytes at ptr, then each block reachable from them once, in
+// breadth-first order, each followed by its links: the offsets of its words
+// pointing into other blocks. A pointer-aligned word is a link if it points
+// into a readable mapping of the process, writable unless followReadOnly,
+// outside of its own block. A block is the allocation containing the target
+// when the allocation registry is enabled (memDumpRegistry.h), otherwise the
+// blockSize bytes at the target, clipped to its mapping and merged with the
+// blocks they overlap. The blocks in the heap that aren't known allocations,
+// possibly freed, and the ones reached from them, are printed as unverified
+void dumpMemoryGraph(const void* ptr,
+                     const std::size_t size,
+                     const DumpOptions& options,
+                     const GraphOptions& graphOptions,
+                     const std::string_view demangledTypeName = {},
+                     std::ostream& os = std::cout) noexcept;
+
+template <typename T>
+void dumpMemoryGraph(const T& var, const GraphOptions& graphOptions = {}, std::ostream& os = std::cout) noexcept {
+  dumpMemoryGraph(&var, sizeof(var), currentDumpOptions(), graphOptions, demangle::typeName<T>(), os);
+}
+}  // namespace memDump
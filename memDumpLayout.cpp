@@ -0,0 +1,138 @@
+//
+// memDumpLayout.cpp
+//
+#include "memDumpLayout.h"
+#include "memDumpMaps.h"
+#include <iomanip>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+namespace {
+// the fields take the range colors in turn; the padding is dimmed
+constexpr std::string_view paddingColor {"\033[2m"};
+constexpr std::ptrdiff_t padding {-1};
+}  // namespace
+
+void dumpFieldLayout(const void* ptr,
+                     const std::size_t size,
+                     const std::size_t alignment,
+                     const FieldDescriptor* fields,
+                     const std::size_t count,
+                     const DumpOptions& options,
+                     const std::string_view demangledTypeName,
+                     std::ostream& os) noexcept {
+  // the stream is given back formatted as the caller left it
+  const std::ios_base::fmtflags flags {os.flags()};
+  const char fill {os.fill()};
+  try {
+    const uptr_t start {reinterpret_cast<uptr_t>(ptr)};
+    const uptr_t end {start + size};
+    const std::size_t paddingBytes {layoutPadding(fields, count, size)};
+
+    // the field of each byte of the object
+    std::vector<std::ptrdiff_t> owner(size, padding);
+    for (std::size_t i {0}; i < count; ++i) {
+      for (std::size_t b {fields[i].offset}; b < std::min(fields[i].offset + fields[i].size, size); ++b) {
+        owner[b] = static_cast<std::ptrdiff_t>(i);
+      }
+    }
+    const bool color {useColors(options, os)};
+    auto colorOf = [color](const std::ptrdiff_t field) -> std::string_view {
+      if (!color) {
+        return {};
+      }
+      return (padding == field) ? paddingColor
+                                : RANGE_COLORS[static_cast<std::size_t>(field) % RANGE_COLOR_COUNT];
+    };
+
+    os << "[memDump:dumpLayout]----------------------------------------------------\n"
+       << "Type " << demangledTypeName << " of " << std::dec << size << " bytes, "
+       << count << " fields, " << paddingBytes << " bytes of padding - Memory to dump starts at: "
+       << std::hex << std::uppercase << ptr << "\n\n";
+
+    HighlightRowRenderer renderer {options, os};
+    const uptr_t rowWidth {renderer.rowWidth()};
+    const DumpWindow window {dumpWindow(ptr, size, options)};
+    const uptr_t windowEnd {window.start() + window.length()};
+    renderer.ruler();
+
+    std::string_view colors[DumpOptions::maxRowWidth];
+    char markers[DumpOptions::maxRowWidth + 1];
+    for (uptr_t address {window.start()}; address < windowEnd; ) {
+      const uptr_t rowStart {address - address % rowWidth};
+      const uptr_t first {address - rowStart};
+      const uptr_t last {std::min(rowWidth, windowEnd - rowStart)};
+
+      // < and > around the object, | between its fields
+      for (uptr_t i {0}; i <= rowWidth; ++i) {
+        const uptr_t a {rowStart + i};
+        markers[i] = ' ';
+        if (i < rowWidth) {
+          colors[i] = {};
+        }
+        if (a == start) {
+          markers[i] = '<';
+        } else if (a == end) {
+          markers[i] = '>';
+        } else if ((a > start) && (a < end) && (owner[a - start] != owner[a - start - 1]) && (padding != owner[a - start])) {
+          markers[i] = '|';
+        }
+        if ((i < rowWidth) && (a >= start) && (a < end)) {
+          colors[i] = colorOf(owner[a - start]);
+        }
+      }
+
+      // with safeRead the row is copied, not dereferenced: its memory may
+      // have been unmapped since the mappings were read
+      byte_t copy[DumpOptions::maxRowWidth];
+      const byte_t* bytes {reinterpret_cast<const byte_t*>(address)};
+      if (options.safeRead) {
+        bytes = (copyMemory(address, last - first, copy) == last - first) ? copy : nullptr;
+      }
+      renderer.styledRow(rowStart,
+                         bytes,
+                         first,
+                         last - first,
+                         colors,
+                         markers);
+      address = rowStart + last;
+    }
+
+    // the fields and the padding, by offset
+    const std::string_view reset {color ? std::string_view {RESET_COLOR} : std::string_view {}};
+    os << "\n\n" << std::dec << std::setfill(' ')
+       << "  offset  size  align  field\n";
+    for (std::size_t offset {0}; offset < size; ) {
+      const std::ptrdiff_t field {owner[offset]};
+      std::size_t next {offset + 1};
+      while ((next < size) && (owner[next] == field)) {
+        ++next;
+      }
+      os << std::setw(8) << offset << std::setw(6) << (next - offset);
+      if (padding == field) {
+        os << "         " << colorOf(field) << "(padding)" << reset << "\n";
+      } else {
+        const FieldDescriptor& f {fields[static_cast<std::size_t>(field)]};
+        os << std::setw(7) << f.alignment << "  " << colorOf(field) << f.name << reset << "\n";
+      }
+      offset = next;
+    }
+
+    const LayoutSuggestion suggestion {suggestLayout(fields, count, alignment)};
+    if (suggestion.size < size) {
+      os << "suggested order:";
+      for (std::size_t i {0}; i < suggestion.count; ++i) {
+        os << ((0 == i) ? " " : ", ") << fields[suggestion.order[i]].name;
+      }
+      os << " - " << suggestion.size << " bytes instead of " << size << "\n";
+    } else {
+      os << "the order of the fields has the smallest size\n";
+    }
+    os << "-----------------------------------------------------------------------\n";
+  } catch (...) {
+    os << "[memDump:dumpLayout] out of memory\n";
+  }
+  os.flags(flags);
+  os.fill(fill);
+}
+}  // namespace memDump
@@ -0,0 +1,135 @@
+//
+// memDumpLayout.h
+//
+// Dumps of objects showing where each of their fields starts and ends, and
+// which bytes are padding, from field descriptors computed at compile time
+//
+#pragma once
+
+#include "memDump.h"
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+////////////////////////////////////////////////////////////////////////////////
+// Describe the fields of a class, at most maxLayoutFields, e.g.
+//   MEMDUMP_LAYOUT(test_t, MEMDUMP_FIELD(a), MEMDUMP_FIELD(i8), MEMDUMP_FIELD(c));
+// at namespace scope; a class with private fields declares
+//   friend struct memDump::FieldLayout<test_t>;
+#define MEMDUMP_LAYOUT(T, ...)                                           \
+  template <>                                                            \
+  struct memDump::FieldLayout<T> {                                       \
+    using type = T;                                                      \
+    static constexpr memDump::FieldDescriptor fields[] {__VA_ARGS__};    \
+    static_assert(std::size(fields) <= memDump::maxLayoutFields,         \
+                  "MEMDUMP_LAYOUT: more fields than maxLayoutFields");   \
+  }
+#define MEMDUMP_FIELD(member)                                            \
+  memDump::FieldDescriptor {#member,                                     \
+                            offsetof(type, member),                      \
+                            sizeof(type::member),                        \
+                            alignof(decltype(type::member))}
+
+namespace memDump
+{
+// a field of a class: where it is, and how it must be aligned
+struct FieldDescriptor {
+  std::string_view name;
+  std::size_t offset;
+  std::size_t size;
+  std::size_t alignment;
+};
+
+// the fields of T, specialized by MEMDUMP_LAYOUT
+template <typename T>
+struct FieldLayout;
+
+template <typename T>
+concept HasFieldLayout = requires { FieldLayout<T>::fields; };
+
+// fields a suggested order can hold
+constexpr std::size_t maxLayoutFields {64};
+
+// An order of the fields with the smallest size
+struct LayoutSuggestion {
+  std::array<std::size_t, maxLayoutFields> order;  // indexes of the fields
+  std::size_t count;
+  std::size_t size;  // of the class with the fields in this order
+};
+
+// The sizes of C++ types are multiples of their alignments, so the fields
+// sorted by decreasing alignment leave no padding between them: only the
+// padding at the end, to the alignment of the class, is left. The fields with
+// the same alignment keep their order
+constexpr LayoutSuggestion suggestLayout(const FieldDescriptor* fields,
+                                         const std::size_t count,
+                                         const std::size_t alignment) noexcept {
+  LayoutSuggestion suggestion {{}, std::min(count, maxLayoutFields), 0};
+  for (std::size_t i {0}; i < suggestion.count; ++i) {
+    std::size_t j {i};
+    for (; (j > 0) && (fields[suggestion.order[j - 1]].alignment < fields[i].alignment); --j) {
+      suggestion.order[j] = suggestion.order[j - 1];
+    }
+    suggestion.order[j] = i;
+  }
+
+  std::size_t offset {0};
+  for (std::size_t i {0}; i < suggestion.count; ++i) {
+    const FieldDescriptor& field {fields[suggestion.order[i]]};
+    offset = (offset + field.alignment - 1) / field.alignment * field.alignment + field.size;
+  }
+  suggestion.size = (offset + alignment - 1) / alignment * alignment;
+  return suggestion;
+}
+
+// the bytes of a class of size not in any of its fields
+constexpr std::size_t layoutPadding(const FieldDescriptor* fields,
+                                    const std::size_t count,
+                                    const std::size_t size) noexcept {
+  std::size_t used {0};
+  for (std::size_t i {0}; i < count; ++i) {
+    used += fields[i].size;
+  }
+  return size - std::min(used, size);
+}
+
+template <HasFieldLayout T>
+constexpr std::size_t paddingOf() noexcept {
+  return layoutPadding(std::data(FieldLayout<T>::fields), std::size(FieldLayout<T>::fields), sizeof(T));
+}
+
+// e.g. static_assert(memDump::suggestedSizeOf<T>() == sizeof(T));
+template <HasFieldLayout T>
+constexpr std::size_t suggestedSizeOf() noexcept {
+  return suggestLayout(std::data(FieldLayout<T>::fields), std::size(FieldLayout<T>::fields), alignof(T)).size;
+}
+
+// Dump the object of size bytes at ptr with each of its fields in its own
+// color and separated by |, then list the fields, the padding, and the order
+// of the fields that minimizes the size
+void dumpFieldLayout(const void* ptr,
+                     const std::size_t size,
+                     const std::size_t alignment,
+                     const FieldDescriptor* fields,
+                     const std::size_t count,
+                     const DumpOptions& options,
+                     const std::string_view demangledTypeName,
+                     std::ostream& os) noexcept;
+
+template <HasFieldLayout T>
+void dumpLayout(const T& object, const DumpOptions& options, std::ostream& os = std::cout) noexcept {
+  dumpFieldLayout(&object,
+                  sizeof(T),
+                  alignof(T),
+                  std::data(FieldLayout<T>::fields),
+                  std::size(FieldLayout<T>::fields),
+                  options,
+                  demangle::typeName<T>(),
+                  os);
+}
+
+template <HasFieldLayout T>
+void dumpLayout(const T& object, std::ostream& os = std::cout) noexcept {
+  dumpLayout(object, currentDumpOptions(), os);
+}
+}  // namespace memDump
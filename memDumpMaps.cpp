@@ -0,0 +1,178 @@
+//
+// memDumpMaps.cpp
+//
+#include "memDumpMaps.h"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <limits>
+#include <sys/uio.h>
+#include <unistd.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+MemoryMap::Regions readMemoryRegions(const pid_t pid) {
+  const std::string path {(0 == pid) ? std::string {"/proc/self/maps"}
+                                     : "/proc/" + std::to_string(pid) + "/maps"};
+  std::ifstream maps {path};
+  MemoryMap::Regions regions;
+  std::string line;
+
+  // 7f2c4a1f2000-7f2c4a1f4000 rw-p 00032000 103:02 1234   /usr/lib/x86_64-linux-gnu/ld-linux-x86-64.so.2
+  while (std::getline(maps, line)) {
+    std::uint64_t begin {};
+    std::uint64_t end {};
+    char perms[5] {};
+    std::uint64_t offset {};
+    int nameStart {0};
+    if (std::sscanf(line.c_str(), "%" SCNx64 "-%" SCNx64 " %4s %" SCNx64 " %*s %*s %n",
+                    &begin, &end, perms, &offset, &nameStart) < 4) {
+      continue;
+    }
+    regions.push_back(MemoryRegion {begin,
+                                    end,
+                                    'r' == perms[0],
+                                    'w' == perms[1],
+                                    'x' == perms[2],
+                                    's' == perms[3],
+                                    offset,
+                                    (nameStart > 0) ? line.substr(static_cast<std::size_t>(nameStart))
+                                                    : std::string {}});
+  }
+  std::sort(regions.begin(), regions.end(),
+            [](const MemoryRegion& a, const MemoryRegion& b) { return a.begin < b.begin; });
+  return regions;
+}
+
+MemoryMap::MemoryMap(const pid_t pid, const std::chrono::milliseconds maxAge) :
+pid_(pid),
+maxAge_(maxAge)
+{
+  refresh();
+}
+
+bool MemoryMap::refresh() noexcept {
+  const std::lock_guard<std::mutex> lock {refreshMutex_};
+  return load();
+}
+
+bool MemoryMap::load() noexcept {
+  try {
+    auto snapshot {std::make_shared<Snapshot>(Snapshot {readMemoryRegions(pid_), std::chrono::steady_clock::now()})};
+    const bool found {!snapshot->regions.empty()};
+    snapshot_.store(std::move(snapshot), std::memory_order_release);
+    return found;
+  } catch (...) {
+    return false;
+  }
+}
+
+std::shared_ptr<const MemoryMap::Regions> MemoryMap::regions() const noexcept {
+  const auto snapshot {snapshot_.load(std::memory_order_acquire)};
+  return std::shared_ptr<const Regions> {snapshot, &snapshot->regions};
+}
+
+MemoryMap::Span MemoryMap::lookup(const Regions& regions, const uptr_t address) noexcept {
+  // the first region ending after address
+  auto region {std::upper_bound(regions.begin(), regions.end(), address,
+                                [](const uptr_t a, const MemoryRegion& r) { return a < r.end; })};
+  if (regions.end() == region) {
+    return Span {false, std::numeric_limits<uptr_t>::max()};
+  }
+  if (address < region->begin) {
+    // in a hole between two mappings
+    return Span {false, region->begin};
+  }
+
+  // extend the span over the adjacent mappings with the same readability
+  const bool readable {region->readable};
+  uptr_t end {region->end};
+  for (++region; (regions.end() != region) && (region->begin == end) && (region->readable == readable); ++region) {
+    end = region->end;
+  }
+  return Span {readable, end};
+}
+
+MemoryMap::Span MemoryMap::spanAt(const uptr_t address) noexcept {
+  auto snapshot {snapshot_.load(std::memory_order_acquire)};
+  if (std::chrono::steady_clock::now() - snapshot->loaded >= maxAge_) {
+    // memory may have been mapped, or unmapped, since the snapshot was taken:
+    // of the threads finding it stale, the first one reads the mappings
+    // again, and the others wait for its snapshot rather than read them too
+    const std::lock_guard<std::mutex> lock {refreshMutex_};
+    if (snapshot_.load(std::memory_order_acquire) == snapshot) {
+      load();
+    }
+    snapshot = snapshot_.load(std::memory_order_acquire);
+  }
+  return lookup(snapshot->regions, address);
+}
+
+bool MemoryMap::isReadable(const uptr_t address, const std::size_t size) noexcept {
+  const uptr_t end {address + size};
+  for (uptr_t a {address}; a < end; ) {
+    const Span span {spanAt(a)};
+    if (!span.readable) {
+      return false;
+    }
+    a = span.end;
+  }
+  return true;
+}
+
+const MemoryRegion* findMemoryRegion(const MemoryMap::Regions& regions, const uptr_t address) noexcept {
+  // the first region ending after address
+  const auto region {std::upper_bound(regions.begin(), regions.end(), address,
+                                      [](const uptr_t a, const MemoryRegion& r) { return a < r.end; })};
+  return ((regions.end() != region) && (address >= region->begin)) ? &*region : nullptr;
+}
+
+bool isScannable(const MemoryRegion& region) noexcept {
+  return region.readable && !region.name.starts_with("/dev/") && !region.name.starts_with("[vvar") &&
+         ("[vsyscall]" != region.name);
+}
+
+MemoryMap& selfMemoryMap() noexcept {
+  static MemoryMap map {};
+  return map;
+}
+
+std::size_t copyMemory(const uptr_t address, const std::size_t size, void* buffer) noexcept {
+  // process_vm_readv() stops at the first page it can't read
+  const iovec local {buffer, size};
+  const iovec remote {reinterpret_cast<void*>(address), size};
+  const ssize_t read {::process_vm_readv(::getpid(), &local, 1, &remote, 1, 0)};
+  if (read >= 0) {
+    return static_cast<std::size_t>(read);
+  }
+  if ((EFAULT == errno) || (0 == size)) {
+    return 0;
+  }
+
+  // process_vm_readv() not permitted, e.g. by a seccomp filter: the kernel
+  // copies the bytes into a pipe, or fails with EFAULT, a page at a time
+  static std::mutex pipeMutex;
+  static int probePipe[2] {-1, -1};
+  const std::lock_guard<std::mutex> lock {pipeMutex};
+  if ((probePipe[0] < 0) && (::pipe2(probePipe, O_CLOEXEC | O_NONBLOCK) < 0)) {
+    probePipe[0] = probePipe[1] = -1;
+    return 0;
+  }
+  const auto page {static_cast<uptr_t>(::sysconf(_SC_PAGESIZE))};
+  std::size_t copied {0};
+  while (copied < size) {
+    const uptr_t from {address + copied};
+    const std::size_t count {std::min<std::size_t>(size - copied, (from / page + 1) * page - from)};
+    if (::write(probePipe[1], reinterpret_cast<const void*>(from), count) != static_cast<ssize_t>(count)) {
+      break;
+    }
+    if (::read(probePipe[0], static_cast<char*>(buffer) + copied, count) != static_cast<ssize_t>(count)) {
+      break;
+    }
+    copied += count;
+  }
+  return copied;
+}
+}  // namespace memDump
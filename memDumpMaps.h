@@ -0,0 +1,106 @@
+//
+// memDumpMaps.h
+//
+// Index of the memory mappings of a process, parsed from /proc/<pid>/maps,
+// to know which addresses can be read without faulting
+//
+#pragma once
+
+#include "memDump.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+struct MemoryRegion {
+  uptr_t begin;     // first address
+  uptr_t end;       // one past the last address
+  bool readable;
+  bool writable;
+  bool executable;
+  bool shared;
+  uptr_t offset;    // offset in the mapped file
+  std::string name; // mapped file, [heap], [stack], ... or empty
+};
+
+// The mappings of a process, sorted by address. The index is an immutable
+// snapshot, shared by the threads using it: it's read again lazily, when it's
+// looked up and older than maxAge. A snapshot can't tell that memory has been
+// unmapped since it was taken: the memory it says readable is to be read with
+// copyMemory(), not dereferenced
+class MemoryMap final {
+public:
+  using Regions = std::vector<MemoryRegion>;
+
+  // where memory with the same readability of an address ends
+  struct Span {
+    bool readable;
+    uptr_t end;
+  };
+
+  // pid 0 is the calling process
+  explicit MemoryMap(const pid_t pid = 0,
+                     const std::chrono::milliseconds maxAge = std::chrono::milliseconds {100});
+
+  MemoryMap(const MemoryMap&) = delete;
+  MemoryMap& operator=(const MemoryMap&) = delete;
+
+  // One lookup for a whole run of readable, or unreadable, memory: the
+  // readability of address, and the end of the run of mappings with the same
+  // readability that contains it
+  Span spanAt(const uptr_t address) noexcept;
+
+  // all the size bytes at address can be read
+  bool isReadable(const uptr_t address, const std::size_t size) noexcept;
+
+  // the current snapshot of the mappings
+  std::shared_ptr<const Regions> regions() const noexcept;
+
+  // read the mappings again; false if they can't be read
+  bool refresh() noexcept;
+
+  pid_t pid() const noexcept {
+    return pid_;
+  }
+
+private:
+  struct Snapshot {
+    Regions regions;
+    std::chrono::steady_clock::time_point loaded;
+  };
+
+  static Span lookup(const Regions& regions, const uptr_t address) noexcept;
+  // read the mappings into a new snapshot, with refreshMutex_ held
+  bool load() noexcept;
+
+  const pid_t pid_;
+  const std::chrono::milliseconds maxAge_;
+  std::mutex refreshMutex_;  // serializes the refreshes, taken by lookups only on a stale snapshot
+  std::atomic<std::shared_ptr<const Snapshot>> snapshot_;
+};
+
+// the mappings of the calling process, shared by all the dumps
+MemoryMap& selfMemoryMap() noexcept;
+
+// Copy the size bytes at address in the calling process to buffer, with a
+// system call that fails instead of faulting on memory that isn't readable:
+// process_vm_readv(), or a pipe where it isn't permitted. Return the number of
+// bytes copied, fewer than size if the memory after them can't be read.
+// Doesn't allocate
+std::size_t copyMemory(const uptr_t address, const std::size_t size, void* buffer) noexcept;
+
+// parse the mappings of a process; empty if they can't be read
+MemoryMap::Regions readMemoryRegions(const pid_t pid = 0);
+
+// the region of regions, sorted by address, containing address; nullptr if none
+const MemoryRegion* findMemoryRegion(const MemoryMap::Regions& regions, const uptr_t address) noexcept;
+
+// the region can be scanned whole: it's readable, and neither the mapping of
+// a device, whose reads may have side effects, nor [vvar], parts of which fault
+bool isScannable(const MemoryRegion& region) noexcept;
+}  // namespace memDump
@@ -0,0 +1,143 @@
+//
+// memDumpParallel.cpp
+//
+#include "memDumpParallel.h"
+#include "memDumpMaps.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+namespace {
+// a formatted chunk, waiting to be written; its memory is reused by the
+// chunks after it
+struct chunkBuffer {
+  ArenaSink text;
+  std::atomic<bool> ready {false};
+  std::unique_ptr<byte_t[]> bytes;  // the chunk copied, with safeRead
+};
+}  // namespace
+
+void dumpMemoryParallel(const void* ptr,
+                        const std::size_t size,
+                        const DumpOptions& options,
+                        const unsigned threads,
+                        const std::string_view demangledTypeName,
+                        std::ostream& os,
+                        const std::size_t chunkRows) noexcept {
+  const DumpWindow window {dumpWindow(ptr, size, options)};
+  const auto bytes {reinterpret_cast<const byte_t*>(window.start())};
+  const uptr_t rowWidth {options.validRowWidth()};
+  const uptr_t chunkSize {std::max<std::size_t>(chunkRows, 1) * rowWidth};
+  const unsigned workers {(0 == threads) ? std::max(std::thread::hardware_concurrency(), 1U) : threads};
+
+  DumpRenderer renderer {window, options, demangledTypeName, os};
+
+  // the first chunk ends at a row boundary, so all the others start at one
+  const uptr_t firstChunkSize {chunkSize - window.start() % rowWidth};
+  if ((0 == window.size) || (workers < 2) || (window.length() <= firstChunkSize + chunkSize) ||
+      (options.safeRead && !selfMemoryMap().isReadable(window.start(), window.length()))) {
+    renderer.renderMemory(options.safeRead);
+    return;
+  }
+  const uptr_t chunks {1 + (window.length() - firstChunkSize + chunkSize - 1) / chunkSize};
+  auto chunkBegin = [&](const uptr_t chunk) -> uptr_t {
+    return (0 == chunk) ? 0 : std::min(firstChunkSize + (chunk - 1) * chunkSize, window.length());
+  };
+
+  // at most inFlight chunks are formatted and not written yet, so that the
+  // memory used doesn't grow with the size of the region
+  const uptr_t inFlight {2 * static_cast<uptr_t>(workers)};
+  std::unique_ptr<chunkBuffer[]> buffers;
+  std::vector<std::thread> pool;
+  try {
+    buffers = std::make_unique<chunkBuffer[]>(inFlight);
+    // the two rows before a chunk are compared with its first one, to collapse it
+    const uptr_t copySize {2 * rowWidth + chunkSize};
+    if (options.safeRead) {
+      for (uptr_t i {0}; i < inFlight; ++i) {
+        buffers[i].bytes = std::make_unique_for_overwrite<byte_t[]>(copySize);
+      }
+    }
+    pool.reserve(workers);
+  } catch (...) {
+    // out of memory: the calling thread formats the window alone
+    renderer.renderMemory(options.safeRead);
+    return;
+  }
+  std::atomic<uptr_t> nextChunk {0};
+  std::atomic<uptr_t> written {0};
+
+  auto render = [&](Sink& sink, chunkBuffer& buffer, const uptr_t chunk) noexcept {
+    const uptr_t begin {chunkBegin(chunk)};
+    const uptr_t end {chunkBegin(chunk + 1)};
+    const byte_t* chunkBytes {bytes + begin};
+    if (options.safeRead) {
+      // copied rather than read in place: the memory may have been
+      // unmapped since the mappings were checked
+      const uptr_t from {begin - std::min<uptr_t>(begin, 2 * rowWidth)};
+      const bool copied {copyMemory(window.start() + from, end - from, buffer.bytes.get()) == end - from};
+      chunkBytes = copied ? buffer.bytes.get() + (begin - from) : nullptr;
+    }
+    renderer.renderChunk(sink, chunkBytes, begin, end);
+  };
+  auto format = [&](const uptr_t chunk) noexcept {
+    chunkBuffer& buffer {buffers[chunk % inFlight]};
+    render(buffer.text, buffer, chunk);
+    buffer.ready.store(true, std::memory_order_release);
+    buffer.ready.notify_one();
+  };
+
+  auto work = [&]() noexcept {
+    for (uptr_t chunk {nextChunk.fetch_add(1, std::memory_order_relaxed)};
+         chunk < chunks;
+         chunk = nextChunk.fetch_add(1, std::memory_order_relaxed)) {
+      // wait for a free buffer
+      for (uptr_t w {written.load(std::memory_order_acquire)}; chunk >= w + inFlight;
+           w = written.load(std::memory_order_acquire)) {
+        written.wait(w, std::memory_order_acquire);
+      }
+      format(chunk);
+    }
+  };
+
+  for (unsigned i {0}; i < workers; ++i) {
+    try {
+      pool.emplace_back(work);
+    } catch (...) {
+      break;  // no more threads: the ones started, and the calling thread, format the chunks
+    }
+  }
+
+  // write the chunks in address order
+  for (uptr_t chunk {0}; chunk < chunks; ++chunk) {
+    chunkBuffer& buffer {buffers[chunk % inFlight]};
+    // the next chunk not taken by a worker yet, e.g. when none could be
+    // started, is formatted here
+    uptr_t next {chunk};
+    if (!buffer.ready.load(std::memory_order_acquire) &&
+        nextChunk.compare_exchange_strong(next, chunk + 1, std::memory_order_relaxed)) {
+      format(chunk);
+    }
+    buffer.ready.wait(false, std::memory_order_acquire);
+    if (buffer.text.truncated()) {
+      // the buffer couldn't grow: the chunk is formatted again, straight
+      // to the output
+      render(renderer.sink(), buffer, chunk);
+    } else {
+      renderer.sink().write(buffer.text.view());
+    }
+    buffer.text.clear();
+    buffer.ready.store(false, std::memory_order_relaxed);
+    written.store(chunk + 1, std::memory_order_release);
+    written.notify_all();
+  }
+
+  for (auto& worker : pool) {
+    worker.join();
+  }
+  renderer.skip(window.length());
+}
+}  // namespace memDump
@@ -0,0 +1,26 @@
+//
+// memDumpParallel.h
+//
+// Dumps of very large regions, e.g. arena snapshots, formatted on a pool of
+// worker threads
+//
+#pragma once
+
+#include "memDump.h"
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+// Dump like dumpMemory() does, with the same output: the window is split at
+// row boundaries into chunks of chunkRows rows, the chunks are formatted by
+// threads worker threads (0: one per core) into per-chunk buffers, and the
+// buffers are written to os in address order by the calling thread.
+// Small regions, and regions not entirely readable with options.safeRead,
+// are formatted by the calling thread
+void dumpMemoryParallel(const void* ptr,
+                        const std::size_t size,
+                        const DumpOptions& options,
+                        const unsigned threads = 0,
+                        const std::string_view demangledTypeName = {},
+                        std::ostream& os = std::cout,
+                        const std::size_t chunkRows = 16384) noexcept;
+}  // namespace memDump
@@ -0,0 +1,256 @@
+//
+// memDumpProcess.cpp
+//
+#include "memDumpProcess.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <unordered_map>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+namespace {
+// iovecs per process_vm_readv() call
+constexpr std::size_t maxIovecs {IOV_MAX};
+}  // namespace
+
+ProcessReader::ProcessReader(const pid_t pid) :
+pid_(pid),
+startTime_(processStartTime(pid)),
+map_(pid)
+{}
+
+ProcessReader::~ProcessReader() {
+  if (memFd_ >= 0) {
+    ::close(memFd_);
+  }
+}
+
+void ProcessReader::read(Request* requests, const std::size_t count) noexcept {
+  const std::lock_guard<std::mutex> lock {readMutex_};
+  try {
+    // the requested ranges, by address
+    std::vector<Request*> sorted(count);
+    for (std::size_t i {0}; i < count; ++i) {
+      requests[i].read = 0;
+      sorted[i] = &requests[i];
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Request* a, const Request* b) { return a->address < b->address; });
+
+    // coalesce the overlapping and adjacent ranges, then keep their readable parts
+    segments_.clear();
+    std::size_t staged {0};
+    for (std::size_t i {0}; i < count; ) {
+      const uptr_t begin {sorted[i]->address};
+      uptr_t end {begin + sorted[i]->size};
+      for (++i; (i < count) && (sorted[i]->address <= end); ++i) {
+        end = std::max<uptr_t>(end, sorted[i]->address + sorted[i]->size);
+      }
+      for (uptr_t address {begin}; address < end; ) {
+        const MemoryMap::Span span {map_.spanAt(address)};
+        const uptr_t spanEnd {std::min(span.end, end)};
+        if (span.readable) {
+          segments_.push_back(Segment {address, spanEnd - address, staged, 0});
+          staged += spanEnd - address;
+        }
+        address = spanEnd;
+      }
+    }
+    staging_.resize(staged);
+    readSegments();
+
+    // copy each request the prefix of its range that has been read
+    auto segment {segments_.begin()};
+    for (Request* request : sorted) {
+      const uptr_t end {request->address + request->size};
+      uptr_t address {request->address};
+      // the segments are sorted too: skip the ones ending before the request
+      while ((segments_.end() != segment) && (segment->address + segment->size <= address)) {
+        ++segment;
+      }
+      for (auto s {segment}; (segments_.end() != s) && (s->address <= address) && (address < end); ++s) {
+        const uptr_t readEnd {std::min<uptr_t>(s->address + s->read, end)};
+        if (readEnd <= address) {
+          break;
+        }
+        std::memcpy(request->buffer + (address - request->address),
+                    &staging_[s->staged + (address - s->address)],
+                    readEnd - address);
+        address = readEnd;
+        if (s->read < s->size) {
+          break;  // the rest of the segment couldn't be read
+        }
+      }
+      request->read = address - request->address;
+    }
+  } catch (...) {
+    // out of memory: nothing read
+  }
+}
+
+void ProcessReader::readSegments() noexcept {
+  iovec local[maxIovecs];
+  iovec remote[maxIovecs];
+
+  for (std::size_t first {0}; first < segments_.size(); ) {
+    if (!useVmReadv_) {
+      readSegmentsFromMem(first);
+      return;
+    }
+
+    const std::size_t batch {std::min(maxIovecs, segments_.size() - first)};
+    std::size_t expected {0};
+    for (std::size_t i {0}; i < batch; ++i) {
+      const Segment& s {segments_[first + i]};
+      local[i] = iovec {&staging_[s.staged], s.size};
+      remote[i] = iovec {reinterpret_cast<void*>(s.address), s.size};
+      expected += s.size;
+    }
+
+    const ssize_t result {::process_vm_readv(pid_, local, batch, remote, batch, 0)};
+    if (result < 0) {
+      if ((ENOSYS == errno) || (EPERM == errno)) {
+        // not permitted: the kernel may still let us read /proc/<pid>/mem
+        useVmReadv_ = false;
+        continue;
+      }
+      // the first segment can't be read (unmapped since the map was read)
+      segments_[first].read = 0;
+      ++first;
+      continue;
+    }
+
+    // a partial read stops at the first segment that can't be read entirely
+    auto done {static_cast<std::size_t>(result)};
+    std::size_t i {0};
+    for (; (i < batch) && (done >= segments_[first + i].size); ++i) {
+      segments_[first + i].read = segments_[first + i].size;
+      done -= segments_[first + i].size;
+    }
+    if (static_cast<std::size_t>(result) == expected) {
+      first += batch;
+    } else {
+      segments_[first + i].read = done;
+      first += i + 1;
+    }
+  }
+}
+
+void ProcessReader::readSegmentsFromMem(const std::size_t first) noexcept {
+  if (memFd_ < 0) {
+    const std::string path {"/proc/" + std::to_string(pid_) + "/mem"};
+    memFd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  }
+  for (std::size_t i {first}; i < segments_.size(); ++i) {
+    Segment& s {segments_[i]};
+    s.read = 0;
+    while ((memFd_ >= 0) && (s.read < s.size)) {
+      const ssize_t result {::pread(memFd_, &staging_[s.staged + s.read], s.size - s.read,
+                                    static_cast<off_t>(s.address + s.read))};
+      if (result <= 0) {
+        break;
+      }
+      s.read += static_cast<std::size_t>(result);
+    }
+  }
+}
+
+std::shared_ptr<ProcessReader> processReader(const pid_t pid) {
+  static std::mutex readersMutex;
+  static std::unordered_map<pid_t, std::shared_ptr<ProcessReader>> readers;
+
+  // a pid is reused once its process has exited: the mappings and the
+  // /proc/<pid>/mem of the cached reader would be those of the previous
+  // process. A replaced reader is destroyed when its last user is done
+  const std::uint64_t startTime {processStartTime(pid)};
+  const std::lock_guard<std::mutex> lock {readersMutex};
+  auto& reader {readers[pid]};
+  if (!reader || (reader->startTime() != startTime)) {
+    reader = std::make_shared<ProcessReader>(pid);
+  }
+  return reader;
+}
+
+std::uint64_t processStartTime(const pid_t pid) noexcept {
+  char path[32];
+  std::snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid));
+  const int fd {::open(path, O_RDONLY | O_CLOEXEC)};
+  if (fd < 0) {
+    return 0;
+  }
+  char stat[1024];
+  const ssize_t size {::read(fd, stat, sizeof(stat) - 1)};
+  ::close(fd);
+  if (size <= 0) {
+    return 0;
+  }
+  stat[size] = '\0';
+
+  // the name, field 2, is in parentheses and may contain spaces and
+  // parentheses: the fields are counted from the last one
+  const char* field {std::strrchr(stat, ')')};
+  for (int i {2}; (nullptr != field) && (i < 22); ++i) {
+    field = std::strchr(field + 1, ' ');
+  }
+  return (nullptr != field) ? std::strtoull(field + 1, nullptr, 10) : 0;
+}
+
+void dumpProcessMemory(const pid_t pid,
+                       const uptr_t address,
+                       const std::size_t size,
+                       std::ostream& os) noexcept {
+  dumpProcessMemory(pid, address, size, currentDumpOptions(), os);
+}
+
+void dumpProcessMemory(const pid_t pid,
+                       const uptr_t address,
+                       const std::size_t size,
+                       const DumpOptions& options,
+                       std::ostream& os) noexcept {
+  try {
+    const DumpWindow window {dumpWindow(reinterpret_cast<const void*>(address), size, options)};
+    std::vector<byte_t> bytes(window.length());
+    const std::shared_ptr<ProcessReader> reader {processReader(pid)};
+
+    // one request for each readable part of the window
+    std::vector<ProcessReader::Request> requests;
+    for (int attempt {0}; (attempt < 2) && requests.empty(); ++attempt) {
+      if (attempt > 0) {
+        // the mappings might have changed since they were read
+        reader->memoryMap().refresh();
+      }
+      for (uptr_t offset {0}; offset < window.length(); ) {
+        const MemoryMap::Span span {reader->memoryMap().spanAt(window.start() + offset)};
+        const uptr_t end {std::min<uptr_t>(span.end - window.start(), window.length())};
+        if (span.readable) {
+          requests.push_back(ProcessReader::Request {window.start() + offset, end - offset, &bytes[offset], 0});
+        }
+        offset = end;
+      }
+    }
+    reader->read(requests.data(), requests.size());
+
+    os << "[memDump:dumpProcessMemory] pid " << std::dec << pid << "\n";
+    DumpRenderer renderer {window, options, "", os};
+    uptr_t offset {0};
+    for (const auto& request : requests) {
+      // what's not read is rendered as unreadable
+      renderer.renderUnreadable(request.address - window.start() - offset);
+      renderer.render(request.buffer, request.read);
+      renderer.renderUnreadable(request.size - request.read);
+      offset = request.address - window.start() + request.size;
+    }
+    renderer.renderUnreadable(window.length() - offset);
+  } catch (...) {
+    os << "[memDump:dumpProcessMemory] pid " << std::dec << pid << ": out of memory\n";
+  }
+}
+}  // namespace memDump
@@ -0,0 +1,100 @@
+//
+// memDumpProcess.h
+//
+// Dumps of the memory of another process, read with batched process_vm_readv()
+// calls, or from /proc/<pid>/mem when those are not permitted
+//
+#pragma once
+
+#include "memDump.h"
+#include "memDumpMaps.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sys/types.h>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+// Reads the memory of a process; one per process is cached by processReader()
+// for as long as the process runs
+class ProcessReader final {
+public:
+  // a range to read into buffer; read is set to the bytes read from the start
+  // of the range, less than size if the rest can't be read
+  struct Request {
+    uptr_t address;
+    std::size_t size;
+    byte_t* buffer;
+    std::size_t read;
+  };
+
+  explicit ProcessReader(const pid_t pid);
+  ~ProcessReader();
+
+  ProcessReader(const ProcessReader&) = delete;
+  ProcessReader& operator=(const ProcessReader&) = delete;
+
+  // Read all the requests: the ranges are sorted, split at the mappings not
+  // readable, and the overlapping or adjacent ones are coalesced; the
+  // resulting segments are read with as few process_vm_readv() calls as
+  // the iovec limit allows. The reads of a reader by several threads are
+  // serialized
+  void read(Request* requests, const std::size_t count) noexcept;
+
+  MemoryMap& memoryMap() noexcept {
+    return map_;
+  }
+
+  pid_t pid() const noexcept {
+    return pid_;
+  }
+
+  // when the process started, in clock ticks since boot; 0 if unknown
+  std::uint64_t startTime() const noexcept {
+    return startTime_;
+  }
+
+private:
+  struct Segment {
+    uptr_t address;
+    std::size_t size;
+    std::size_t staged;  // offset in the staging buffer
+    std::size_t read;
+  };
+
+  void readSegments() noexcept;
+  void readSegmentsFromMem(std::size_t first) noexcept;
+
+  const pid_t pid_;
+  const std::uint64_t startTime_;
+  MemoryMap map_;
+  std::mutex readMutex_;  // guards the members below, reused by each read
+  int memFd_ {-1};  // /proc/<pid>/mem, opened on first use
+  bool useVmReadv_ {true};
+  std::vector<Segment> segments_;
+  std::vector<byte_t> staging_;
+};
+
+// The reader of the process pid, created and cached on first use. It's
+// replaced when pid is now another process, started since, e.g. after the
+// process exited and its pid was reused
+std::shared_ptr<ProcessReader> processReader(const pid_t pid);
+
+// when the process pid started, in clock ticks since boot: field 22 of
+// /proc/<pid>/stat; 0 if it can't be read, e.g. the process has exited
+std::uint64_t processStartTime(const pid_t pid) noexcept;
+
+// Dump size bytes at address in the process pid, with the context of
+// options; the bytes that can't be read are printed as ??
+void dumpProcessMemory(const pid_t pid,
+                       const uptr_t address,
+                       const std::size_t size,
+                       const DumpOptions& options,
+                       std::ostream& os = std::cout) noexcept;
+
+void dumpProcessMemory(const pid_t pid,
+                       const uptr_t address,
+                       const std::size_t size,
+                       std::ostream& os = std::cout) noexcept;
+}  // namespace memDump
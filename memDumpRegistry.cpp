@@ -0,0 +1,343 @@
+//
+// memDumpRegistry.cpp
+//
+#include "memDumpRegistry.h"
+#include <algorithm>
+#include <vector>
+#if defined(MEMDUMP_ALLOCATION_REGISTRY)
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#endif
+////////////////////////////////////////////////////////////////////////////////
+#if defined(MEMDUMP_ALLOCATION_REGISTRY)
+namespace memDump {
+namespace {
+// The registry is a hash table of allocations by address, with open
+// addressing, split in shards of their own cache lines. A slot is claimed
+// with a CAS of its key, filled, then published with the address: no locks,
+// and the memory is static, so the registry never allocates
+constexpr std::size_t shardCount {64};
+constexpr std::size_t slotsPerShard {16384};
+
+constexpr uptr_t emptyKey {0};
+constexpr uptr_t deletedKey {1};
+constexpr uptr_t busyKey {2};  // being filled
+
+struct Slot {
+  std::atomic<uptr_t> key;
+  std::atomic<std::size_t> size;
+  std::atomic<const char*> type;
+  std::atomic<std::size_t> typeSize;
+};
+
+struct alignas(64) Shard {
+  std::atomic<std::size_t> live;
+  std::atomic<std::size_t> dropped;
+  std::atomic<std::size_t> allocated;
+  Slot slots[slotsPerShard];
+};
+
+Shard shards[shardCount] {};
+
+thread_local std::string_view currentTag {};
+
+std::size_t slotHash(const uptr_t address) noexcept {
+  return static_cast<std::size_t>(((address >> 4) * 0x9E3779B97F4A7C15) >> 32);
+}
+
+void registerAllocation(void* ptr, const std::size_t size) noexcept {
+  const auto address {reinterpret_cast<uptr_t>(ptr)};
+  const std::size_t hash {slotHash(address)};
+  Shard& shard {shards[hash % shardCount]};
+  const std::size_t start {hash / shardCount};
+  shard.allocated.fetch_add(1, std::memory_order_relaxed);
+
+  for (std::size_t probe {0}; probe < slotsPerShard; ++probe) {
+    Slot& slot {shard.slots[(start + probe) % slotsPerShard]};
+    uptr_t key {slot.key.load(std::memory_order_relaxed)};
+    // the address can't be in the table: it was erased before being freed
+    if (((emptyKey == key) || (deletedKey == key)) &&
+        slot.key.compare_exchange_strong(key, busyKey, std::memory_order_acquire, std::memory_order_relaxed)) {
+      slot.size.store(size, std::memory_order_relaxed);
+      slot.type.store(currentTag.data(), std::memory_order_relaxed);
+      slot.typeSize.store(currentTag.size(), std::memory_order_relaxed);
+      slot.key.store(address, std::memory_order_release);
+      shard.live.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  shard.dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void unregisterAllocation(void* ptr) noexcept {
+  if (nullptr == ptr) {
+    return;
+  }
+  const auto address {reinterpret_cast<uptr_t>(ptr)};
+  const std::size_t hash {slotHash(address)};
+  Shard& shard {shards[hash % shardCount]};
+  const std::size_t start {hash / shardCount};
+
+  for (std::size_t probe {0}; probe < slotsPerShard; ++probe) {
+    Slot& slot {shard.slots[(start + probe) % slotsPerShard]};
+    const uptr_t key {slot.key.load(std::memory_order_relaxed)};
+    if (address == key) {
+      slot.key.store(deletedKey, std::memory_order_release);
+      shard.live.fetch_sub(1, std::memory_order_relaxed);
+      return;
+    }
+    if (emptyKey == key) {
+      return;  // dropped when allocated
+    }
+  }
+}
+
+// call f with each live allocation until it returns false
+template <typename F>
+void forEachAllocation(F&& f) noexcept {
+  for (Shard& shard : shards) {
+    if (0 == shard.live.load(std::memory_order_relaxed)) {
+      continue;
+    }
+    for (Slot& slot : shard.slots) {
+      const uptr_t key {slot.key.load(std::memory_order_acquire)};
+      if (key > busyKey) {
+        const Allocation allocation {key,
+                                     slot.size.load(std::memory_order_relaxed),
+                                     {slot.type.load(std::memory_order_relaxed), slot.typeSize.load(std::memory_order_relaxed)}};
+        if (!f(allocation)) {
+          return;
+        }
+      }
+    }
+  }
+}
+
+void* allocate(const std::size_t size, const std::size_t alignment) noexcept {
+  void* ptr {nullptr};
+  for (;;) {
+    if (alignment <= alignof(std::max_align_t)) {
+      ptr = std::malloc(std::max<std::size_t>(size, 1));
+    } else if (0 != ::posix_memalign(&ptr, alignment, std::max<std::size_t>(size, 1))) {
+      ptr = nullptr;
+    }
+    if (nullptr != ptr) {
+      registerAllocation(ptr, size);
+      return ptr;
+    }
+    const std::new_handler handler {std::get_new_handler()};
+    if (nullptr == handler) {
+      return nullptr;
+    }
+    try {
+      handler();
+    } catch (...) {
+      return nullptr;
+    }
+  }
+}
+
+void deallocate(void* ptr) noexcept {
+  // out of the registry before the address can be given out again
+  unregisterAllocation(ptr);
+  std::free(ptr);
+}
+}  // namespace
+
+ScopedAllocationTag::ScopedAllocationTag(const std::string_view type) noexcept :
+previous_(currentTag)
+{
+  currentTag = type;
+}
+
+ScopedAllocationTag::~ScopedAllocationTag() {
+  currentTag = previous_;
+}
+
+AllocationRegistryStats allocationRegistryStats() noexcept {
+  AllocationRegistryStats stats {0, 0, 0};
+  for (const Shard& shard : shards) {
+    stats.live += shard.live.load(std::memory_order_relaxed);
+    stats.dropped += shard.dropped.load(std::memory_order_relaxed);
+    stats.allocated += shard.allocated.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+bool findAllocation(const void* address, Allocation& allocation) noexcept {
+  const auto target {reinterpret_cast<uptr_t>(address)};
+  bool found {false};
+  forEachAllocation([&](const Allocation& a) {
+    if ((a.address <= target) && (target < a.address + std::max<std::size_t>(a.size, 1))) {
+      allocation = a;
+      found = true;
+    }
+    return !found;
+  });
+  return found;
+}
+
+std::size_t liveAllocations(const std::string_view type,
+                            Allocation* allocations,
+                            const std::size_t capacity) noexcept {
+  std::size_t count {0};
+  forEachAllocation([&](const Allocation& a) {
+    if (type.empty() || (type == a.type)) {
+      if (count < capacity) {
+        allocations[count] = a;
+      }
+      ++count;
+    }
+    return true;
+  });
+  return count;
+}
+}  // namespace memDump
+
+////////////////////////////////////////////////////////////////////////////////
+// the global allocation functions, replaced
+void* operator new(const std::size_t size) {
+  void* const ptr {memDump::allocate(size, 0)};
+  if (nullptr == ptr) {
+    throw std::bad_alloc {};
+  }
+  return ptr;
+}
+
+void* operator new[](const std::size_t size) {
+  return ::operator new(size);
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept {
+  return memDump::allocate(size, 0);
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept {
+  return memDump::allocate(size, 0);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment) {
+  void* const ptr {memDump::allocate(size, static_cast<std::size_t>(alignment))};
+  if (nullptr == ptr) {
+    throw std::bad_alloc {};
+  }
+  return ptr;
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment) {
+  return ::operator new(size, alignment);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return memDump::allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return memDump::allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+  memDump::deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  memDump::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  memDump::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  memDump::deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  memDump::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  memDump::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  memDump::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  memDump::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+  memDump::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+  memDump::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+  memDump::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+  memDump::deallocate(ptr);
+}
+#else
+namespace memDump {
+AllocationRegistryStats allocationRegistryStats() noexcept {
+  return AllocationRegistryStats {0, 0, 0};
+}
+
+bool findAllocation(const void*, Allocation&) noexcept {
+  return false;
+}
+
+std::size_t liveAllocations(const std::string_view, Allocation*, const std::size_t) noexcept {
+  return 0;
+}
+}  // namespace memDump
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+void dumpAllocations(const std::string_view type,
+                     const DumpOptions& options,
+                     std::ostream& os) noexcept {
+  if (!allocationRegistryEnabled) {
+    std::cerr << "memDump::dumpAllocations: built without MEMDUMP_ALLOCATION_REGISTRY\n";
+    return;
+  }
+  try {
+    // the buffer is allocated before the registry is read: some room for the
+    // allocations made meanwhile
+    std::vector<Allocation> allocations(allocationRegistryStats().live + 64);
+    const std::size_t count {std::min(liveAllocations(type, allocations.data(), allocations.size()),
+                                      allocations.size())};
+    std::sort(allocations.begin(), allocations.begin() + static_cast<std::ptrdiff_t>(count),
+              [](const Allocation& a, const Allocation& b) { return a.address < b.address; });
+
+    os << "[memDump:dumpAllocations] " << std::dec << count << " live allocations of "
+       << (type.empty() ? std::string_view {"any type"} : type) << "\n";
+    for (std::size_t i {0}; i < count; ++i) {
+      dumpMemory(reinterpret_cast<const void*>(allocations[i].address), allocations[i].size, options, allocations[i].type, os);
+    }
+  } catch (...) {
+    std::cerr << "memDump::dumpAllocations: out of memory\n";
+  }
+}
+
+bool dumpAllocationAt(const void* address,
+                      const DumpOptions& options,
+                      std::ostream& os) noexcept {
+  Allocation allocation {};
+  if (!findAllocation(address, allocation)) {
+    return false;
+  }
+  os << "[memDump:dumpAllocationAt] " << address << " is at offset " << std::dec
+     << (reinterpret_cast<uptr_t>(address) - allocation.address) << " of the allocation\n";
+  dumpMemory(reinterpret_cast<const void*>(allocation.address), allocation.size, options, allocation.type, os);
+  return true;
+}
+}  // namespace memDump
@@ -0,0 +1,109 @@
+//
+// memDumpRegistry.h
+//
+// A registry of the live heap allocations, filled by the global operator new
+// and operator delete, so that the heap objects can be dumped by type or by
+// an address inside them. It's compiled in only with
+// MEMDUMP_ALLOCATION_REGISTRY defined (cmake -DMEMDUMP_ALLOCATION_REGISTRY=ON);
+// otherwise the functions below do nothing and the allocations are untouched
+//
+#pragma once
+
+#include "memDump.h"
+#include <cstddef>
+#include <string_view>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+#if defined(MEMDUMP_ALLOCATION_REGISTRY)
+constexpr bool allocationRegistryEnabled {true};
+#else
+constexpr bool allocationRegistryEnabled {false};
+#endif
+
+// a live allocation; type is empty if it wasn't tagged
+struct Allocation {
+  uptr_t address;
+  std::size_t size;
+  std::string_view type;
+};
+
+struct AllocationRegistryStats {
+  std::size_t live;       // allocations in the registry
+  std::size_t dropped;    // allocations not recorded: the registry was full
+  std::size_t allocated;  // allocations since startup, recorded or not
+};
+
+// Tag the allocations of the calling thread with type while in scope, e.g.
+// around a std::make_shared<Foo>(); the innermost tag wins. type must outlive
+// the allocations, as the names of demangle::typeName() do
+class ScopedAllocationTag final {
+public:
+#if defined(MEMDUMP_ALLOCATION_REGISTRY)
+  explicit ScopedAllocationTag(const std::string_view type) noexcept;
+  ~ScopedAllocationTag();
+#else
+  explicit ScopedAllocationTag(const std::string_view) noexcept {}
+#endif
+
+  ScopedAllocationTag(const ScopedAllocationTag&) = delete;
+  ScopedAllocationTag& operator=(const ScopedAllocationTag&) = delete;
+
+private:
+#if defined(MEMDUMP_ALLOCATION_REGISTRY)
+  const std::string_view previous_;
+#endif
+};
+
+// A base of T tagging the objects created with new T with the name of T:
+//   struct Foo : memDump::TrackedAllocation<Foo> { ... };
+template <typename T>
+struct TrackedAllocation {
+  static void* operator new(const std::size_t size) {
+    const ScopedAllocationTag tag {demangle::typeName<T>()};
+    return ::operator new(size);
+  }
+
+  static void* operator new[](const std::size_t size) {
+    const ScopedAllocationTag tag {demangle::typeName<T>()};
+    return ::operator new[](size);
+  }
+
+  static void operator delete(void* ptr) noexcept {
+    ::operator delete(ptr);
+  }
+
+  static void operator delete[](void* ptr) noexcept {
+    ::operator delete[](ptr);
+  }
+};
+
+AllocationRegistryStats allocationRegistryStats() noexcept;
+
+// Find the live allocation containing address; false if none. The registry
+// is scanned: the lookups are for diagnostics, the allocations only pay for
+// an insert
+bool findAllocation(const void* address, Allocation& allocation) noexcept;
+
+// Copy up to capacity of the live allocations tagged type, all of them if
+// type is empty, to allocations; return how many there are, even past
+// capacity. Nothing is allocated
+std::size_t liveAllocations(const std::string_view type,
+                            Allocation* allocations,
+                            const std::size_t capacity) noexcept;
+
+// dump each live allocation tagged type
+void dumpAllocations(const std::string_view type,
+                     const DumpOptions& options,
+                     std::ostream& os = std::cout) noexcept;
+
+template <typename T>
+void dumpAllocationsOf(std::ostream& os = std::cout) noexcept {
+  dumpAllocations(demangle::typeName<T>(), currentDumpOptions(), os);
+}
+
+// dump the live allocation containing address, if any
+bool dumpAllocationAt(const void* address,
+                      const DumpOptions& options,
+                      std::ostream& os = std::cout) noexcept;
+}  // namespace memDump
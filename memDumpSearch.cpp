@@ -0,0 +1,360 @@
+//
+// memDumpSearch.cpp
+//
+#include "memDumpSearch.h"
+#include "memDumpFile.h"
+#include "memDumpMaps.h"
+#include "memDumpProcess.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+namespace {
+// bytes searched by a worker at a time
+constexpr uptr_t chunkSize {4UL << 20};
+// bytes of another process read at a time
+constexpr uptr_t readSize {16UL << 20};
+
+// the positions to search: a match can start at the first positions bytes,
+// followed by the size of the pattern minus one bytes; the matches are
+// reported at address plus their offset
+struct SearchRange {
+  const byte_t* bytes;
+  uptr_t positions;
+  uptr_t address;
+};
+
+SearchRange searchRange(const BytePattern& pattern, const byte_t* bytes, const uptr_t size, const uptr_t address) noexcept {
+  return SearchRange {bytes, (size >= pattern.size()) ? size - pattern.size() + 1 : 0, address};
+}
+
+// Search the ranges, split in chunks, on threads workers; the matches at
+// excluded aren't reported
+bool searchRanges(const BytePattern& pattern,
+                  const SearchRange* ranges,
+                  const std::size_t rangeCount,
+                  std::vector<uptr_t>& matches,
+                  const unsigned threads,
+                  const std::size_t maxMatches,
+                  const uptr_t excluded = 0) noexcept {
+  struct Chunk {
+    std::size_t range;
+    uptr_t begin;
+    uptr_t end;
+  };
+
+  try {
+    std::vector<Chunk> chunks;
+    for (std::size_t r {0}; r < rangeCount; ++r) {
+      for (uptr_t begin {0}; begin < ranges[r].positions; begin += chunkSize) {
+        chunks.push_back(Chunk {r, begin, std::min(begin + chunkSize, ranges[r].positions)});
+      }
+    }
+    if (pattern.empty() || chunks.empty() || (0 == maxMatches)) {
+      return true;
+    }
+
+    const unsigned workers {static_cast<unsigned>(std::min<std::size_t>(
+        (0 == threads) ? std::max(std::thread::hardware_concurrency(), 1U) : threads, chunks.size()))};
+    std::vector<std::vector<uptr_t>> found(workers);
+    std::atomic<std::size_t> nextChunk {0};
+    std::atomic<std::size_t> count {0};
+
+    auto work = [&](std::vector<uptr_t>& workerMatches) noexcept {
+      for (std::size_t c {nextChunk.fetch_add(1, std::memory_order_relaxed)};
+           (c < chunks.size()) && (count.load(std::memory_order_relaxed) < maxMatches);
+           c = nextChunk.fetch_add(1, std::memory_order_relaxed)) {
+        const Chunk& chunk {chunks[c]};
+        const SearchRange& range {ranges[chunk.range]};
+        pattern.forEachMatch(range.bytes + chunk.begin, chunk.end - chunk.begin, [&](const uptr_t offset) noexcept {
+          const uptr_t address {range.address + chunk.begin + offset};
+          if (address == excluded) {
+            return true;
+          }
+          if (count.fetch_add(1, std::memory_order_relaxed) >= maxMatches) {
+            return false;
+          }
+          try {
+            workerMatches.push_back(address);
+          } catch (...) {
+            return false;  // the matches found so far are kept
+          }
+          return true;
+        });
+      }
+    };
+
+    if (1 == workers) {
+      work(found[0]);
+    } else {
+      std::vector<std::thread> pool;
+      pool.reserve(workers);
+      for (unsigned i {0}; i < workers; ++i) {
+        pool.emplace_back(work, std::ref(found[i]));
+      }
+      for (auto& worker : pool) {
+        worker.join();
+      }
+    }
+
+    const std::size_t first {matches.size()};
+    for (const auto& workerMatches : found) {
+      matches.insert(matches.end(), workerMatches.begin(), workerMatches.end());
+    }
+    std::sort(matches.begin() + static_cast<std::ptrdiff_t>(first), matches.end());
+  } catch (...) {
+    std::cerr << "memDump::findPattern: out of memory\n";
+    return false;
+  }
+  return true;
+}
+
+void printMatchCount(const std::size_t count, const BytePattern& pattern, std::ostream& os) {
+  os << "[memDump:find] " << std::dec << count << ((1 == count) ? " match" : " matches")
+     << " of the " << pattern.size() << " bytes pattern\n";
+}
+
+int hexDigit(const char c) noexcept {
+  if ((c >= '0') && (c <= '9')) {
+    return c - '0';
+  }
+  if ((c >= 'a') && (c <= 'f')) {
+    return c - 'a' + 10;
+  }
+  if ((c >= 'A') && (c <= 'F')) {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+}  // namespace
+
+BytePattern::BytePattern(const void* bytes, const std::size_t size, const void* mask) :
+bytes_(static_cast<const byte_t*>(bytes), static_cast<const byte_t*>(bytes) + size),
+mask_(size, byte_t {0xFF})
+{
+  if (nullptr != mask) {
+    std::memcpy(mask_.data(), mask, size);
+    for (std::size_t i {0}; i < size; ++i) {
+      bytes_[i] &= mask_[i];
+    }
+  }
+  chooseFilter();
+}
+
+bool BytePattern::parse(const std::string_view text, BytePattern& pattern) {
+  std::vector<byte_t> bytes;
+  std::vector<byte_t> mask;
+  unsigned nibbles {0};
+
+  for (const char c : text) {
+    if (' ' == c) {
+      continue;
+    }
+    const int digit {hexDigit(c)};
+    if ((digit < 0) && ('?' != c)) {
+      return false;
+    }
+    if (0 == nibbles % 2) {
+      bytes.push_back(0);
+      mask.push_back(0);
+    }
+    // the high nibble first
+    const unsigned shift {(0 == nibbles % 2) ? 4U : 0U};
+    if (digit >= 0) {
+      bytes.back() = static_cast<byte_t>(bytes.back() | (digit << shift));
+      mask.back() = static_cast<byte_t>(mask.back() | (0xF << shift));
+    }
+    ++nibbles;
+  }
+  if ((0 == nibbles) || (0 != nibbles % 2)) {
+    return false;
+  }
+  pattern = BytePattern {bytes.data(), bytes.size(), mask.data()};
+  return true;
+}
+
+void BytePattern::chooseFilter() noexcept {
+  // the zero bytes are the most common in memory: a byte of the pattern
+  // that isn't zero filters more positions out
+  auto firstOf = [&](const bool nonZero) -> std::size_t {
+    for (std::size_t i {0}; i < bytes_.size(); ++i) {
+      if ((0xFF == mask_[i]) && (!nonZero || (0 != bytes_[i]))) {
+        return i;
+      }
+    }
+    return bytes_.size();
+  };
+  auto lastOf = [&](const bool nonZero) -> std::size_t {
+    for (std::size_t i {bytes_.size()}; i > 0; --i) {
+      if ((0xFF == mask_[i - 1]) && (!nonZero || (0 != bytes_[i - 1]))) {
+        return i - 1;
+      }
+    }
+    return bytes_.size();
+  };
+
+  first_ = firstOf(true);
+  second_ = lastOf(true);
+  if (first_ == bytes_.size()) {
+    first_ = firstOf(false);
+    second_ = lastOf(false);
+  }
+  filtered_ = first_ < bytes_.size();
+}
+
+bool findPattern(const BytePattern& pattern,
+                 const void* ptr,
+                 const std::size_t size,
+                 std::vector<uptr_t>& matches,
+                 const unsigned threads,
+                 const std::size_t maxMatches) noexcept {
+  const SearchRange range {searchRange(pattern, static_cast<const byte_t*>(ptr), size, reinterpret_cast<uptr_t>(ptr))};
+  return searchRanges(pattern, &range, 1, matches, threads, maxMatches);
+}
+
+bool findPatternInMemory(const BytePattern& pattern,
+                         std::vector<uptr_t>& matches,
+                         const unsigned threads,
+                         const std::size_t maxMatches) noexcept {
+  MemoryMap& map {selfMemoryMap()};
+  map.refresh();
+  const auto regions {map.regions()};
+  if (!regions) {
+    return false;
+  }
+  try {
+    std::vector<SearchRange> ranges;
+    for (const MemoryRegion& region : *regions) {
+      if (isScannable(region)) {
+        ranges.push_back(searchRange(pattern, reinterpret_cast<const byte_t*>(region.begin),
+                                     region.end - region.begin, region.begin));
+      }
+    }
+    return searchRanges(pattern, ranges.data(), ranges.size(), matches, threads, maxMatches,
+                        reinterpret_cast<uptr_t>(pattern.data()));
+  } catch (...) {
+    std::cerr << "memDump::findPatternInMemory: out of memory\n";
+    return false;
+  }
+}
+
+std::size_t dumpPatternMatches(const BytePattern& pattern,
+                               const void* ptr,
+                               const std::size_t size,
+                               const DumpOptions& options,
+                               const std::size_t maxMatches,
+                               std::ostream& os) noexcept {
+  std::vector<uptr_t> matches;
+  if (!findPattern(pattern, ptr, size, matches, 0, maxMatches)) {
+    return 0;
+  }
+  printMatchCount(matches.size(), pattern, os);
+  for (const uptr_t address : matches) {
+    dumpMemory(reinterpret_cast<const void*>(address), pattern.size(), options, "pattern match", os);
+  }
+  return matches.size();
+}
+
+std::size_t dumpPatternMatches(const BytePattern& pattern,
+                               const DumpOptions& options,
+                               const std::size_t maxMatches,
+                               std::ostream& os) noexcept {
+  std::vector<uptr_t> matches;
+  if (!findPatternInMemory(pattern, matches, 0, maxMatches)) {
+    return 0;
+  }
+  printMatchCount(matches.size(), pattern, os);
+  for (const uptr_t address : matches) {
+    dumpMemory(reinterpret_cast<const void*>(address), pattern.size(), options, "pattern match", os);
+  }
+  return matches.size();
+}
+
+std::size_t dumpProcessPatternMatches(const pid_t pid,
+                                      const BytePattern& pattern,
+                                      const DumpOptions& options,
+                                      const std::size_t maxMatches,
+                                      std::ostream& os) noexcept {
+  std::vector<uptr_t> matches;
+  try {
+    const std::shared_ptr<ProcessReader> reader {processReader(pid)};
+    reader->memoryMap().refresh();
+    const auto regions {reader->memoryMap().regions()};
+    if (!regions || pattern.empty()) {
+      return 0;
+    }
+
+    // each read overlaps the next one by the size of the pattern minus one,
+    // for the matches across them
+    std::vector<byte_t> buffer(readSize + pattern.size() - 1);
+    for (const MemoryRegion& region : *regions) {
+      if (!isScannable(region)) {
+        continue;
+      }
+      for (uptr_t address {region.begin}; (address < region.end) && (matches.size() < maxMatches);
+           address += readSize) {
+        ProcessReader::Request request {address, std::min<uptr_t>(buffer.size(), region.end - address), buffer.data(), 0};
+        reader->read(&request, 1);
+        SearchRange range {searchRange(pattern, buffer.data(), request.read, address)};
+        range.positions = std::min(range.positions, readSize);
+        if (!searchRanges(pattern, &range, 1, matches, 0, maxMatches - matches.size())) {
+          break;
+        }
+      }
+    }
+  } catch (...) {
+    std::cerr << "memDump::dumpProcessPatternMatches: out of memory\n";
+  }
+
+  printMatchCount(matches.size(), pattern, os);
+  for (const uptr_t address : matches) {
+    dumpProcessMemory(pid, address, pattern.size(), options, os);
+  }
+  return matches.size();
+}
+
+std::size_t dumpFilePatternMatches(const char* path,
+                                   const BytePattern& pattern,
+                                   const DumpOptions& options,
+                                   const std::size_t maxMatches,
+                                   std::ostream& os) noexcept {
+  const int fd {::open(path, O_RDONLY | O_CLOEXEC)};
+  struct stat st {};
+  if ((fd < 0) || (::fstat(fd, &st) < 0)) {
+    std::cerr << "memDump::dumpFilePatternMatches: " << path << ": " << std::strerror(errno) << "\n";
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    return 0;
+  }
+
+  std::vector<uptr_t> matches;
+  const auto fileSize {static_cast<uptr_t>(st.st_size)};
+  if (fileSize > 0) {
+    void* map {::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0)};
+    if (MAP_FAILED == map) {
+      std::cerr << "memDump::dumpFilePatternMatches: " << path << ": mmap: " << std::strerror(errno) << "\n";
+    } else {
+      ::madvise(map, fileSize, MADV_SEQUENTIAL);
+      // the file offsets are the addresses of the matches
+      const SearchRange range {searchRange(pattern, static_cast<const byte_t*>(map), fileSize, 0)};
+      searchRanges(pattern, &range, 1, matches, 0, maxMatches);
+      ::munmap(map, fileSize);
+    }
+  }
+  ::close(fd);
+
+  printMatchCount(matches.size(), pattern, os);
+  for (const uptr_t offset : matches) {
+    dumpFile(path, offset, pattern.size(), options, os);
+  }
+  return matches.size();
+}
+}  // namespace memDump
@@ -0,0 +1,152 @@
+//
+// memDumpSearch.h
+//
+// Searches of byte patterns, e.g. a canary, a sentinel or an ASCII key, in a
+// range, in the mappings of the process, of another process or in a file,
+// with the context of each match dumped. Two bytes of the pattern are
+// compared at every position with vector instructions, the whole pattern
+// only where they match
+//
+#pragma once
+
+#include "memDump.h"
+#include "memDumpSimd.h"
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <sys/types.h>
+#include <type_traits>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+// Bytes to find, with a mask: the bits cleared in the mask of a byte match
+// anything
+class BytePattern final {
+public:
+  BytePattern() = default;
+  // size bytes, all their bits compared without mask
+  BytePattern(const void* bytes, const std::size_t size, const void* mask = nullptr);
+
+  // the bytes of value in memory, e.g. BytePattern::of(std::uint64_t {0x4044444444444441})
+  template <typename T>
+    requires std::is_trivially_copyable_v<T>
+  static BytePattern of(const T& value) {
+    return BytePattern {&value, sizeof(value)};
+  }
+
+  // the characters of text, without terminating zero
+  static BytePattern text(const std::string_view text) {
+    return BytePattern {text.data(), text.size()};
+  }
+
+  // Parse hex bytes in memory order, with optional spaces; ? is a wildcard
+  // nibble: "41 44 ?? 4?". Return false if text isn't a pattern
+  static bool parse(const std::string_view text, BytePattern& pattern);
+
+  std::size_t size() const noexcept {
+    return bytes_.size();
+  }
+
+  bool empty() const noexcept {
+    return bytes_.empty();
+  }
+
+  // the size() bytes at bytes match
+  bool matches(const byte_t* bytes) const noexcept {
+    for (std::size_t i {0}; i < bytes_.size(); ++i) {
+      if ((bytes[i] & mask_[i]) != bytes_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Call f(offset), in order, for each match at an offset below count in
+  // the count + size() - 1 bytes at bytes, until f returns false
+  template <typename F>
+  void forEachMatch(const byte_t* bytes, const std::size_t count, F&& f) const noexcept;
+
+  // the storage of the pattern, not reported as a match in the process
+  const byte_t* data() const noexcept {
+    return bytes_.data();
+  }
+
+private:
+  // the bytes compared first: two fully compared bytes, non zero if possible
+  void chooseFilter() noexcept;
+
+  std::vector<byte_t> bytes_;  // masked
+  std::vector<byte_t> mask_;
+  bool filtered_ {false};      // some bytes are fully compared
+  std::size_t first_ {0};
+  std::size_t second_ {0};
+};
+
+template <typename F>
+void BytePattern::forEachMatch(const byte_t* bytes, const std::size_t count, F&& f) const noexcept {
+  if (bytes_.empty()) {
+    return;
+  }
+  if (!filtered_) {
+    for (std::size_t i {0}; i < count; ++i) {
+      if (matches(bytes + i) && !f(i)) {
+        return;
+      }
+    }
+    return;
+  }
+  simd::forEachBytePair(bytes + first_, count, bytes_[first_], second_ - first_, bytes_[second_],
+                        [&](const std::size_t i) noexcept { return !matches(bytes + i) || f(i); });
+}
+
+constexpr std::size_t unlimitedMatches {std::numeric_limits<std::size_t>::max()};
+
+// Append to matches the addresses of the matches of pattern in the size bytes
+// at ptr, in order, up to maxMatches. The range is split in chunks searched
+// by threads worker threads (0: one per core); with several, the matches kept
+// past maxMatches are the first found, not always the lowest ones. Return
+// false if out of memory
+bool findPattern(const BytePattern& pattern,
+                 const void* ptr,
+                 const std::size_t size,
+                 std::vector<uptr_t>& matches,
+                 const unsigned threads = 1,
+                 const std::size_t maxMatches = unlimitedMatches) noexcept;
+
+// The same in all the readable mappings of the calling process, but the
+// pattern itself and the mappings of devices. The mappings must not be
+// unmapped during the search
+bool findPatternInMemory(const BytePattern& pattern,
+                         std::vector<uptr_t>& matches,
+                         const unsigned threads = 0,
+                         const std::size_t maxMatches = unlimitedMatches) noexcept;
+
+// Dump the matches of pattern in the size bytes at ptr, or in all the
+// mappings of the process, with the context of options; return their number
+std::size_t dumpPatternMatches(const BytePattern& pattern,
+                               const void* ptr,
+                               const std::size_t size,
+                               const DumpOptions& options,
+                               const std::size_t maxMatches = 100,
+                               std::ostream& os = std::cout) noexcept;
+
+std::size_t dumpPatternMatches(const BytePattern& pattern,
+                               const DumpOptions& options,
+                               const std::size_t maxMatches = 100,
+                               std::ostream& os = std::cout) noexcept;
+
+// The same in the readable mappings of the process pid, read a chunk at a time
+std::size_t dumpProcessPatternMatches(const pid_t pid,
+                                      const BytePattern& pattern,
+                                      const DumpOptions& options,
+                                      const std::size_t maxMatches = 100,
+                                      std::ostream& os = std::cout) noexcept;
+
+// The same in the file at path, with the file offsets as addresses
+std::size_t dumpFilePatternMatches(const char* path,
+                                   const BytePattern& pattern,
+                                   const DumpOptions& options,
+                                   const std::size_t maxMatches = 100,
+                                   std::ostream& os = std::cout) noexcept;
+}  // namespace memDump
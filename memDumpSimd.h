@@ -0,0 +1,122 @@
+//
+// memDumpSimd.h
+//
+// Vectorized byte comparisons, with AVX2 or SSE2 when the target has them
+// (-march=native) and a word at a time otherwise
+//
+#pragma once
+
+#include "memDump.h"
+#include <cstdint>
+#include <cstring>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump::simd
+{
+// the index of the first byte that differs in a and b, or size if none does
+inline std::size_t firstDifference(const byte_t* a, const byte_t* b, const std::size_t size) noexcept {
+  std::size_t i {0};
+#if defined(__AVX2__)
+  for (; i + 32 <= size; i += 32) {
+    const __m256i va {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i))};
+    const __m256i vb {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))};
+    const auto equal {static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)))};
+    if (0xFFFFFFFFU != equal) {
+      return i + static_cast<std::size_t>(__builtin_ctz(~equal));
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  for (; i + 16 <= size; i += 16) {
+    const __m128i va {_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i))};
+    const __m128i vb {_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))};
+    const auto equal {static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)))};
+    if (0xFFFFU != equal) {
+      return i + static_cast<std::size_t>(__builtin_ctz(~equal));
+    }
+  }
+#endif
+  for (; i + 8 <= size; i += 8) {
+    std::uint64_t wa {};
+    std::uint64_t wb {};
+    std::memcpy(&wa, a + i, 8);
+    std::memcpy(&wb, b + i, 8);
+    if (wa != wb) {
+      break;  // the byte is found below
+    }
+  }
+  for (; i < size; ++i) {
+    if (a[i] != b[i]) {
+      return i;
+    }
+  }
+  return size;
+}
+
+// bit i set if a[i] != b[i], for size up to 64 bytes
+inline std::uint64_t differenceMask(const byte_t* a, const byte_t* b, const std::size_t size) noexcept {
+  std::uint64_t mask {0};
+  std::size_t i {0};
+#if defined(__SSE2__)
+  for (; i + 16 <= size; i += 16) {
+    const __m128i va {_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i))};
+    const __m128i vb {_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))};
+    const auto equal {static_cast<std::uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)))};
+    mask |= (~equal & 0xFFFFU) << i;
+  }
+#endif
+  for (; i < size; ++i) {
+    mask |= static_cast<std::uint64_t>(a[i] != b[i]) << i;
+  }
+  return mask;
+}
+
+// Call f(i), in order, for each i < count with a[i] == x and a[i + distance]
+// == y, until f returns false: the filter of the pattern searches, two bytes
+// compared at every position a vector at a time. a must have count + distance
+// bytes
+template <typename F>
+inline void forEachBytePair(const byte_t* a,
+                            const std::size_t count,
+                            const byte_t x,
+                            const std::size_t distance,
+                            const byte_t y,
+                            F&& f) noexcept {
+  std::size_t i {0};
+#if defined(__AVX2__)
+  const __m256i vx {_mm256_set1_epi8(static_cast<char>(x))};
+  const __m256i vy {_mm256_set1_epi8(static_cast<char>(y))};
+  for (; i + 32 <= count; i += 32) {
+    const __m256i first {_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)), vx)};
+    const __m256i second {_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + distance)), vy)};
+    for (auto found {static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(first, second)))};
+         0 != found; found &= found - 1) {
+      if (!f(i + static_cast<std::size_t>(__builtin_ctz(found)))) {
+        return;
+      }
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i wx {_mm_set1_epi8(static_cast<char>(x))};
+  const __m128i wy {_mm_set1_epi8(static_cast<char>(y))};
+  for (; i + 16 <= count; i += 16) {
+    const __m128i first {_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), wx)};
+    const __m128i second {_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + distance)), wy)};
+    for (auto found {static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_and_si128(first, second)))};
+         0 != found; found &= found - 1) {
+      if (!f(i + static_cast<std::size_t>(__builtin_ctz(found)))) {
+        return;
+      }
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    if ((a[i] == x) && (a[i + distance] == y) && !f(i)) {
+      return;
+    }
+  }
+}
+}  // namespace memDump::simd
@@ -0,0 +1,106 @@
+//
+// memDumpSink.cpp
+//
+#include "memDumpSink.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <sys/uio.h>
+#include <unistd.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+void BufferSink::write(const char* data, const std::size_t size) noexcept {
+  const std::size_t copied {std::min(size, capacity_ - size_)};
+  std::memcpy(buffer_ + size_, data, copied);
+  size_ += copied;
+  truncated_ = truncated_ || (copied < size);
+}
+
+FdSink::~FdSink() {
+  flush();
+}
+
+void FdSink::write(const char* data, const std::size_t size) noexcept {
+  if (size_ + size <= bufferSize) {
+    std::memcpy(buffer_ + size_, data, size);
+    size_ += size;
+    return;
+  }
+  writeAll(data, size);
+}
+
+void FdSink::flush() noexcept {
+  writeAll(nullptr, 0);
+}
+
+bool FdSink::terminal() const noexcept {
+  return 1 == ::isatty(fd_);
+}
+
+void FdSink::writeAll(const char* data, const std::size_t size) noexcept {
+  iovec iov[2] {{buffer_, size_}, {const_cast<char*>(data), size}};
+  int first {0};
+  while ((first < 2) && !failed_) {
+    if (0 == iov[first].iov_len) {
+      ++first;
+      continue;
+    }
+    const ssize_t written {::writev(fd_, &iov[first], 2 - first)};
+    if (written < 0) {
+      failed_ = (EINTR != errno);
+      continue;
+    }
+    // skip what's been written, maybe part of an iovec
+    auto done {static_cast<std::size_t>(written)};
+    for (; (first < 2) && (done >= iov[first].iov_len); ++first) {
+      done -= iov[first].iov_len;
+    }
+    if (first < 2) {
+      iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + done;
+      iov[first].iov_len -= done;
+    }
+  }
+  size_ = 0;
+}
+
+ArenaSink::~ArenaSink() {
+  if (nullptr != buffer_) {
+    resource_->deallocate(buffer_, capacity_);
+  }
+}
+
+void ArenaSink::write(const char* data, const std::size_t size) noexcept {
+  if (size_ + size > capacity_) {
+    // double the buffer, at least
+    const std::size_t capacity {std::max({capacity_ * 2, size_ + size, std::size_t {4096}})};
+    char* buffer {nullptr};
+    try {
+      buffer = static_cast<char*>(resource_->allocate(capacity, 1));
+    } catch (...) {
+      truncated_ = true;
+      return;
+    }
+    if (nullptr != buffer_) {
+      std::memcpy(buffer, buffer_, size_);
+      resource_->deallocate(buffer_, capacity_);
+    }
+    buffer_ = buffer;
+    capacity_ = capacity;
+  }
+  std::memcpy(buffer_ + size_, data, size);
+  size_ += size;
+}
+
+bool OstreamSink::terminal() const noexcept {
+  // the standard streams, checked once
+  static const bool stdoutTerminal {1 == ::isatty(STDOUT_FILENO)};
+  static const bool stderrTerminal {1 == ::isatty(STDERR_FILENO)};
+  const std::streambuf* buffer {os_.rdbuf()};
+  if (buffer == std::cout.rdbuf()) {
+    return stdoutTerminal;
+  }
+  return ((buffer == std::cerr.rdbuf()) || (buffer == std::clog.rdbuf())) && stderrTerminal;
+}
+}  // namespace memDump
@@ -0,0 +1,191 @@
+//
+// memDumpSink.h
+//
+// Destinations of the text of the dumps: a caller's buffer, a file
+// descriptor, a growable arena, or a std::ostream. The dumps write each row
+// with a single call; the sinks allocate only if they are built to
+//
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <ostream>
+#include <string_view>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+class Sink {
+public:
+  virtual ~Sink() = default;
+
+  // append size bytes of text
+  virtual void write(const char* data, const std::size_t size) noexcept = 0;
+  // hand the text buffered, if any, to its destination
+  virtual void flush() noexcept {}
+  // the text goes to a terminal, which shows the colors
+  virtual bool terminal() const noexcept {
+    return false;
+  }
+
+  void write(const std::string_view text) noexcept {
+    write(text.data(), text.size());
+  }
+};
+
+// A fixed buffer of the caller: the text that doesn't fit is dropped
+class BufferSink final : public Sink {
+public:
+  BufferSink(char* buffer, const std::size_t capacity) noexcept :
+  buffer_(buffer),
+  capacity_(capacity)
+  {}
+
+  void write(const char* data, const std::size_t size) noexcept override;
+  using Sink::write;
+
+  std::string_view view() const noexcept {
+    return {buffer_, size_};
+  }
+
+  // some text has been dropped
+  bool truncated() const noexcept {
+    return truncated_;
+  }
+
+  void clear() noexcept {
+    size_ = 0;
+    truncated_ = false;
+  }
+
+private:
+  char* const buffer_;
+  const std::size_t capacity_;
+  std::size_t size_ {0};
+  bool truncated_ {false};
+};
+
+// A file descriptor, written with one write() or writev() call each time the
+// internal buffer fills, and on flush()
+class FdSink final : public Sink {
+public:
+  explicit FdSink(const int fd) noexcept :
+  fd_(fd)
+  {}
+  // flush()
+  ~FdSink() override;
+
+  FdSink(const FdSink&) = delete;
+  FdSink& operator=(const FdSink&) = delete;
+
+  void write(const char* data, const std::size_t size) noexcept override;
+  void flush() noexcept override;
+  bool terminal() const noexcept override;
+  using Sink::write;
+
+  // a write has failed: the text has been dropped
+  bool failed() const noexcept {
+    return failed_;
+  }
+
+private:
+  static constexpr std::size_t bufferSize {16384};
+
+  // write the buffer, then size bytes of data, with a single writev()
+  void writeAll(const char* data, const std::size_t size) noexcept;
+
+  const int fd_;
+  std::size_t size_ {0};
+  bool failed_ {false};
+  char buffer_[bufferSize];
+};
+
+// A buffer growing as needed, allocated from a memory resource: e.g. a
+// std::pmr::monotonic_buffer_resource on memory of the caller
+class ArenaSink final : public Sink {
+public:
+  explicit ArenaSink(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept :
+  resource_(resource)
+  {}
+  ~ArenaSink() override;
+
+  ArenaSink(const ArenaSink&) = delete;
+  ArenaSink& operator=(const ArenaSink&) = delete;
+
+  void write(const char* data, const std::size_t size) noexcept override;
+  using Sink::write;
+
+  std::string_view view() const noexcept {
+    return {buffer_, size_};
+  }
+
+  // the resource has run out of memory: some text has been dropped
+  bool truncated() const noexcept {
+    return truncated_;
+  }
+
+  // keep the memory, for the next text
+  void clear() noexcept {
+    size_ = 0;
+    truncated_ = false;
+  }
+
+private:
+  std::pmr::memory_resource* const resource_;
+  char* buffer_ {nullptr};
+  std::size_t size_ {0};
+  std::size_t capacity_ {0};
+  bool truncated_ {false};
+};
+
+// A std::ostream, written without formatting: nothing is buffered by the sink
+class OstreamSink final : public Sink {
+public:
+  explicit OstreamSink(std::ostream& os) noexcept :
+  os_(os)
+  {}
+
+  void write(const char* data, const std::size_t size) noexcept override {
+    os_.write(data, static_cast<std::streamsize>(size));
+  }
+  // std::cout, std::cerr or std::clog on a terminal
+  bool terminal() const noexcept override;
+  using Sink::write;
+
+  std::ostream& stream() noexcept {
+    return os_;
+  }
+
+private:
+  std::ostream& os_;
+};
+
+// Writes to another sink, counting the bytes
+class CountingSink final : public Sink {
+public:
+  explicit CountingSink(Sink& sink) noexcept :
+  sink_(sink)
+  {}
+
+  void write(const char* data, const std::size_t size) noexcept override {
+    count_ += size;
+    sink_.write(data, size);
+  }
+  using Sink::write;
+
+  void flush() noexcept override {
+    sink_.flush();
+  }
+
+  bool terminal() const noexcept override {
+    return sink_.terminal();
+  }
+
+  std::size_t count() const noexcept {
+    return count_;
+  }
+
+private:
+  Sink& sink_;
+  std::size_t count_ {0};
+};
+}  // namespace memDump
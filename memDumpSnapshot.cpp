@@ -0,0 +1,94 @@
+//
+// memDumpSnapshot.cpp
+//
+#include "memDumpSnapshot.h"
+#include "memDumpMaps.h"
+#include "memDumpSimd.h"
+#include <chrono>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+Snapshot Snapshot::capture(const void* ptr, const std::size_t size) {
+  Snapshot snapshot {};
+  const auto address {reinterpret_cast<uptr_t>(ptr)};
+  if (!selfMemoryMap().isReadable(address, size)) {
+    return snapshot;
+  }
+
+  snapshot.address_ = address;
+  snapshot.timestamp_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  // copied, in case the memory has been unmapped since the mappings were read
+  snapshot.bytes_.resize(size);
+  if (copyMemory(address, size, snapshot.bytes_.data()) < size) {
+    return Snapshot {};
+  }
+  return snapshot;
+}
+
+void dumpSnapshotDiff(const Snapshot& before,
+                      const Snapshot& after,
+                      std::ostream& os) noexcept {
+  dumpSnapshotDiff(before, after, currentDumpOptions(), os);
+}
+
+void dumpSnapshotDiff(const Snapshot& before,
+                      const Snapshot& after,
+                      const DumpOptions& options,
+                      std::ostream& os) noexcept {
+  // the stream is given back formatted as the caller left it
+  const std::ios_base::fmtflags flags {os.flags()};
+  const char fill {os.fill()};
+
+  const byte_t* const a {before.data()};
+  const byte_t* const b {after.data()};
+  const std::size_t size {after.size()};
+  const std::size_t common {std::min(before.size(), size)};
+
+  HighlightRowRenderer renderer {options, os};
+  const uptr_t rowWidth {renderer.rowWidth()};
+  const uptr_t start {after.address()};
+  // the offset in the snapshots of the first byte of each row
+  auto rowOffset = [start, rowWidth](const std::size_t offset) -> std::size_t {
+    return offset - (start + offset) % rowWidth;
+  };
+
+  os << "[memDump:dumpSnapshotDiff]---------------------------------------------\n"
+     << std::dec << size << " bytes at " << reinterpret_cast<const void*>(start)
+     << " - changes in the " << (after.timestamp() - before.timestamp())
+     << " ns between the snapshots\n\n";
+  renderer.ruler();
+
+  std::size_t changed {0};
+  bool skipping {false};
+  for (std::size_t row {0}; row < size; ) {
+    // the bytes of the row in the snapshots, and those changed
+    const uptr_t first {(0 == row) ? start % rowWidth : 0};
+    const std::size_t count {std::min<std::size_t>(rowWidth - first, size - row)};
+    const std::size_t compared {(row < common) ? std::min(count, common - row) : 0};
+    std::uint64_t highlighted {simd::differenceMask(a + row, b + row, compared)};
+    for (std::size_t i {compared}; i < count; ++i) {
+      highlighted |= std::uint64_t {1} << i;
+    }
+
+    if (0 != highlighted) {
+      changed += static_cast<std::size_t>(__builtin_popcountll(highlighted));
+      renderer.row(start + row - first, b + row, first, count, highlighted << first);
+      skipping = false;
+      row += count;
+      continue;
+    }
+
+    // the rows with no changes: jump to the row of the next change
+    if (!skipping) {
+      renderer.skipped();
+      skipping = true;
+    }
+    const std::size_t next {row + count + simd::firstDifference(a + row + count, b + row + count, common - row - count)};
+    row = (next < size) ? std::max(row + count, rowOffset(next)) : size;
+  }
+  os << "\n" << std::dec << changed << " bytes changed"
+     << "\n-----------------------------------------------------------------------\n";
+  os.flags(flags);
+  os.fill(fill);
+}
+}  // namespace memDump
@@ -0,0 +1,68 @@
+//
+// memDumpSnapshot.h
+//
+// Snapshots of memory regions, and dumps of the bytes changed between two
+// snapshots
+//
+#pragma once
+
+#include "memDump.h"
+#include <cstdint>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+// A copy of size bytes at an address, taken at a point in time
+class Snapshot final {
+public:
+  Snapshot() = default;
+
+  // copy size bytes at ptr; empty if they are not all readable
+  static Snapshot capture(const void* ptr, const std::size_t size);
+
+  template <typename T>
+  static Snapshot capture(const T& var) {
+    return capture(&var, sizeof(var));
+  }
+
+  uptr_t address() const noexcept {
+    return address_;
+  }
+
+  std::size_t size() const noexcept {
+    return bytes_.size();
+  }
+
+  const byte_t* data() const noexcept {
+    return bytes_.data();
+  }
+
+  // ns since epoch
+  std::int64_t timestamp() const noexcept {
+    return timestamp_;
+  }
+
+  bool empty() const noexcept {
+    return bytes_.empty();
+  }
+
+private:
+  uptr_t address_ {0};
+  std::int64_t timestamp_ {0};
+  std::vector<byte_t> bytes_ {};
+};
+
+// Dump after, highlighting the bytes changed since before; the runs of rows
+// with no changes are collapsed into a * line. The snapshots are compared
+// byte by byte from their start: the bytes of after past the end of before
+// are all changed. The rows are compared with vector instructions, so that
+// mostly identical snapshots are diffed at memory bandwidth
+void dumpSnapshotDiff(const Snapshot& before,
+                      const Snapshot& after,
+                      const DumpOptions& options,
+                      std::ostream& os = std::cout) noexcept;
+
+void dumpSnapshotDiff(const Snapshot& before,
+                      const Snapshot& after,
+                      std::ostream& os = std::cout) noexcept;
+}  // namespace memDump
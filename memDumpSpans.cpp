@@ -0,0 +1,302 @@
+//
+// memDumpSpans.cpp
+//
+#include "memDumpSpans.h"
+#include "memDumpMaps.h"
+#include <algorithm>
+#include <iomanip>
+#include <set>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+namespace {
+constexpr std::size_t noSpan {static_cast<std::size_t>(-1)};
+
+// the bytes up to end in the color of span, noSpan for none
+struct Segment {
+  uptr_t end;
+  std::size_t span;
+};
+
+// A span clipped to the window
+struct Bounds {
+  uptr_t begin;
+  uptr_t end;
+  std::size_t span;
+};
+
+// The window cut where the innermost span changes: a sweep over the starts and
+// ends of the spans, keeping the spans open by nesting rank
+std::vector<Segment> segmentsOf(const std::vector<Bounds>& bounds, const uptr_t windowEnd) {
+  // the outer spans first: by start, then the longest first
+  std::vector<std::size_t> order(bounds.size());
+  for (std::size_t i {0}; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&bounds](const std::size_t a, const std::size_t b) {
+    return (bounds[a].begin < bounds[b].begin) ||
+           ((bounds[a].begin == bounds[b].begin) && (bounds[a].end > bounds[b].end));
+  });
+
+  // the starts and ends, each with the rank of its span; the ends first
+  struct Event {
+    uptr_t address;
+    bool start;
+    std::size_t rank;
+  };
+  std::vector<Event> events;
+  events.reserve(2 * bounds.size());
+  for (std::size_t rank {0}; rank < order.size(); ++rank) {
+    events.push_back(Event {bounds[order[rank]].begin, true, rank});
+    events.push_back(Event {bounds[order[rank]].end, false, rank});
+  }
+  std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+    return (a.address < b.address) || ((a.address == b.address) && !a.start && b.start);
+  });
+
+  std::vector<Segment> segments;
+  std::set<std::size_t> open;
+  for (std::size_t e {0}; e < events.size(); ) {
+    const uptr_t address {events[e].address};
+    const std::size_t before {open.empty() ? noSpan : bounds[order[*open.rbegin()]].span};
+    for (; (e < events.size()) && (events[e].address == address); ++e) {
+      if (events[e].start) {
+        open.insert(events[e].rank);
+      } else {
+        open.erase(events[e].rank);
+      }
+    }
+    const std::size_t after {open.empty() ? noSpan : bounds[order[*open.rbegin()]].span};
+    if (after != before) {
+      segments.push_back(Segment {address, before});
+    }
+  }
+  segments.push_back(Segment {windowEnd, noSpan});
+  return segments;
+}
+
+// Render the rows of the bytes begin through end - 1, each byte of bounds in
+// the color of its innermost span; linear in the bytes, but for the sorts
+void renderRows(HighlightRowRenderer& renderer,
+                const uptr_t begin,
+                const uptr_t end,
+                const std::vector<Bounds>& bounds,
+                const std::vector<std::string_view>& spanColors,
+                const bool safeRead) {
+  std::vector<uptr_t> starts;
+  std::vector<uptr_t> ends;
+  starts.reserve(bounds.size());
+  ends.reserve(bounds.size());
+  for (const Bounds& b : bounds) {
+    starts.push_back(b.begin);
+    ends.push_back(b.end);
+  }
+  std::sort(starts.begin(), starts.end());
+  std::sort(ends.begin(), ends.end());
+  const std::vector<Segment> segments {segmentsOf(bounds, end)};
+
+  // the addresses only grow, so the edges and the segments are walked once
+  std::size_t start {0};
+  std::size_t stop {0};
+  std::size_t segment {0};
+  auto isEdge = [](const std::vector<uptr_t>& edges, std::size_t& next, const uptr_t address) {
+    while ((next < edges.size()) && (edges[next] < address)) {
+      ++next;
+    }
+    return (next < edges.size()) && (edges[next] == address);
+  };
+
+  const uptr_t rowWidth {renderer.rowWidth()};
+  std::string_view colors[DumpOptions::maxRowWidth];
+  char markers[DumpOptions::maxRowWidth + 1];
+  for (uptr_t address {begin}; address < end; ) {
+    const uptr_t rowStart {address - address % rowWidth};
+    const uptr_t first {address - rowStart};
+    const uptr_t last {std::min(rowWidth, end - rowStart)};
+
+    // < where spans start, > where they end, | where both
+    for (uptr_t i {0}; i <= rowWidth; ++i) {
+      const uptr_t a {rowStart + i};
+      const bool starting {isEdge(starts, start, a)};
+      const bool ending {isEdge(ends, stop, a)};
+      markers[i] = (starting && ending) ? '|' : starting ? '<' : ending ? '>' : ' ';
+      if (i < rowWidth) {
+        colors[i] = {};
+        if ((i >= first) && (i < last)) {
+          while (segments[segment].end <= a) {
+            ++segment;
+          }
+          if (noSpan != segments[segment].span) {
+            colors[i] = spanColors[segments[segment].span];
+          }
+        }
+      }
+    }
+
+    // copied with safeRead: copyMemory() fails on the pages unmapped meanwhile
+    byte_t copy[DumpOptions::maxRowWidth];
+    const byte_t* bytes {reinterpret_cast<const byte_t*>(address)};
+    if (safeRead) {
+      bytes = (copyMemory(address, last - first, copy) == last - first) ? copy : nullptr;
+    }
+    renderer.styledRow(rowStart,
+                       bytes,
+                       first,
+                       last - first,
+                       colors,
+                       markers);
+    address = rowStart + last;
+  }
+}
+
+// the color of each span, none without colors
+std::vector<std::string_view> colorsOf(const HighlightSpan* spans, const std::size_t count, const bool color) {
+  std::vector<std::string_view> colors(count);
+  for (std::size_t i {0}; color && (i < count); ++i) {
+    colors[i] = spans[i].color.empty() ? RANGE_COLORS[i % RANGE_COLOR_COUNT] : spans[i].color;
+  }
+  return colors;
+}
+
+// the indexes of the spans by address
+std::vector<std::size_t> byAddress(const HighlightSpan* spans, const std::size_t count) {
+  std::vector<std::size_t> order(count);
+  for (std::size_t i {0}; i < count; ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [spans](const std::size_t a, const std::size_t b) {
+    return spans[a].address < spans[b].address;
+  });
+  return order;
+}
+}  // namespace
+
+void dumpMemorySpans(const void* ptr,
+                     const std::size_t size,
+                     const HighlightSpan* spans,
+                     const std::size_t count,
+                     const DumpOptions& options,
+                     const std::string_view demangledTypeName,
+                     std::ostream& os) noexcept {
+  // the stream is given back formatted as the caller left it
+  const std::ios_base::fmtflags flags {os.flags()};
+  const char fill {os.fill()};
+  try {
+    const DumpWindow window {dumpWindow(ptr, size, options)};
+    const uptr_t windowEnd {window.start() + window.length()};
+    const bool color {useColors(options, os)};
+    const std::string_view reset {color ? std::string_view {RESET_COLOR} : std::string_view {}};
+    const std::vector<std::string_view> spanColors {colorsOf(spans, count, color)};
+
+    // the spans in the window
+    std::vector<Bounds> bounds;
+    std::vector<bool> shown(count, false);
+    for (std::size_t i {0}; i < count; ++i) {
+      const auto begin {std::max(reinterpret_cast<uptr_t>(spans[i].address), window.start())};
+      const auto end {std::min(reinterpret_cast<uptr_t>(spans[i].address) + spans[i].size, windowEnd)};
+      if (begin < end) {
+        bounds.push_back(Bounds {begin, end, i});
+        shown[i] = true;
+      }
+    }
+
+    os << "[memDump:dumpMemorySpans]-----------------------------------------------\n";
+    if (!demangledTypeName.empty()) {
+      os << "Type " << demangledTypeName << " of ";
+    }
+    os << std::dec << size << " bytes, " << count << ((1 == count) ? " span" : " spans")
+       << " - Memory to dump starts at: " << std::hex << std::uppercase << ptr << "\n\n";
+
+    HighlightRowRenderer renderer {options, os};
+    renderer.ruler();
+    renderRows(renderer, window.start(), windowEnd, bounds, spanColors, options.safeRead);
+
+    // the spans, by offset from ptr
+    os << "\n\n" << std::dec << std::setfill(' ')
+       << "  offset    size  span\n";
+    for (const std::size_t i : byAddress(spans, count)) {
+      const auto offset {reinterpret_cast<std::intptr_t>(spans[i].address) - reinterpret_cast<std::intptr_t>(ptr)};
+      os << std::setw(8) << offset << std::setw(8) << spans[i].size << "  " << spanColors[i] << spans[i].label
+         << reset << (shown[i] ? "\n" : " (outside of the dump)\n");
+    }
+    os << "-----------------------------------------------------------------------\n";
+  } catch (...) {
+    os << "[memDump:dumpMemorySpans] out of memory\n";
+  }
+  os.flags(flags);
+  os.fill(fill);
+}
+
+void dumpMemoryBatch(const HighlightSpan* ranges,
+                     const std::size_t count,
+                     const DumpOptions& options,
+                     std::ostream& os) noexcept {
+  // the stream is given back formatted as the caller left it
+  const std::ios_base::fmtflags flags {os.flags()};
+  const char fill {os.fill()};
+  try {
+    const bool color {useColors(options, os)};
+    const std::string_view reset {color ? std::string_view {RESET_COLOR} : std::string_view {}};
+    const std::vector<std::string_view> rangeColors {colorsOf(ranges, count, color)};
+    const uptr_t rowWidth {options.validRowWidth()};
+
+    // the window of each range, by start
+    std::vector<Bounds> windows;
+    windows.reserve(count);
+    for (std::size_t i {0}; i < count; ++i) {
+      const DumpWindow window {dumpWindow(ranges[i].address, ranges[i].size, options)};
+      windows.push_back(Bounds {window.start(), window.start() + window.length(), i});
+    }
+    std::sort(windows.begin(), windows.end(), [](const Bounds& a, const Bounds& b) {
+      return a.begin < b.begin;
+    });
+
+    // the windows merged where they share a row, or their rows touch
+    std::vector<Bounds> intervals;
+    for (const Bounds& w : windows) {
+      if (!intervals.empty() && (w.begin / rowWidth <= (intervals.back().end + rowWidth - 1) / rowWidth)) {
+        intervals.back().end = std::max(intervals.back().end, w.end);
+      } else {
+        intervals.push_back(Bounds {w.begin, w.end, 0});
+      }
+    }
+
+    os << "[memDump:dumpMemoryBatch]-----------------------------------------------\n"
+       << std::dec << count << ((1 == count) ? " range in " : " ranges in ") << intervals.size()
+       << ((1 == intervals.size()) ? " window\n\n" : " windows\n\n");
+
+    HighlightRowRenderer renderer {options, os};
+    renderer.ruler();
+    // the ranges of each interval, in the order of their windows
+    std::vector<Bounds> bounds;
+    std::size_t next {0};
+    for (std::size_t interval {0}; interval < intervals.size(); ++interval) {
+      if (interval > 0) {
+        renderer.skipped();
+      }
+      bounds.clear();
+      for (; (next < windows.size()) && (windows[next].begin < intervals[interval].end); ++next) {
+        const HighlightSpan& range {ranges[windows[next].span]};
+        const auto begin {reinterpret_cast<uptr_t>(range.address)};
+        if (range.size > 0) {
+          bounds.push_back(Bounds {begin, begin + range.size, windows[next].span});
+        }
+      }
+      renderRows(renderer, intervals[interval].begin, intervals[interval].end, bounds, rangeColors, options.safeRead);
+    }
+
+    // the ranges, by address
+    os << "\n\n" << std::setfill(' ')
+       << "  address               size  range\n";
+    for (const std::size_t i : byAddress(ranges, count)) {
+      os << "  " << std::hex << std::uppercase << ranges[i].address << std::dec << std::setw(10) << ranges[i].size
+         << "  " << rangeColors[i] << ranges[i].label << reset << "\n";
+    }
+    os << "-----------------------------------------------------------------------\n";
+  } catch (...) {
+    os << "[memDump:dumpMemoryBatch] out of memory\n";
+  }
+  os.flags(flags);
+  os.fill(fill);
+}
+}  // namespace memDump
@@ -0,0 +1,62 @@
+//
+// memDumpSpans.h
+//
+// Dumps highlighting any number of labeled ranges, nested or not, each in its
+// own color, e.g. a message, its header, and a field of the header; and
+// dumps of many ranges at once, e.g. elements of an array, each row printed
+// once however many ranges it is in the context of
+//
+#pragma once
+
+#include "memDump.h"
+#include <initializer_list>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+struct HighlightSpan {
+  const void* address;
+  std::size_t size;
+  std::string_view label;
+  std::string_view color {};  // an escape sequence; empty: one of RANGE_COLORS, by index
+};
+
+// the span of the bytes of object
+template <typename T>
+HighlightSpan spanOf(const T& object, const std::string_view label, const std::string_view color = {}) noexcept {
+  return HighlightSpan {&object, sizeof(object), label, color};
+}
+
+// Dump the size bytes at ptr with the context of options, each byte of the
+// spans in the color of the innermost span holding it: the one starting
+// last, the shortest of those starting at the same byte. < and > mark where
+// spans start and end, | where one ends and another starts; the spans are
+// then listed by offset from ptr, with their labels. The escape sequences
+// are printed only where the color changes
+void dumpMemorySpans(const void* ptr,
+                     const std::size_t size,
+                     const HighlightSpan* spans,
+                     const std::size_t count,
+                     const DumpOptions& options,
+                     const std::string_view demangledTypeName,
+                     std::ostream& os) noexcept;
+
+template <typename T>
+void dumpMemorySpans(const T& var, const std::initializer_list<HighlightSpan> spans, std::ostream& os = std::cout) noexcept {
+  dumpMemorySpans(&var, sizeof(var), spans.begin(), spans.size(), currentDumpOptions(), demangle::typeName<T>(), os);
+}
+
+// Dump count ranges with one header and one ruler: the windows of the ranges,
+// with the context of options, are sorted and merged where their rows overlap
+// or touch, then each merged window is rendered once with its ranges
+// highlighted as by dumpMemorySpans(); a * stands for the rows between two
+// windows. The ranges are then listed by address, with their labels. O(n log n)
+// in the ranges, plus linear in the bytes dumped
+void dumpMemoryBatch(const HighlightSpan* ranges,
+                     const std::size_t count,
+                     const DumpOptions& options,
+                     std::ostream& os) noexcept;
+
+inline void dumpMemoryBatch(const std::initializer_list<HighlightSpan> ranges, std::ostream& os = std::cout) noexcept {
+  dumpMemoryBatch(ranges.begin(), ranges.size(), currentDumpOptions(), os);
+}
+}  // namespace memDump
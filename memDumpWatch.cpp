@@ -0,0 +1,229 @@
+//
+// memDumpWatch.cpp
+//
+#include "memDumpWatch.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <optional>
+#include <sys/mman.h>
+#include <unistd.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump {
+namespace {
+// bit of a /proc/<pid>/pagemap entry set when the page is written after the
+// soft-dirty bits are cleared
+constexpr std::uint64_t softDirtyBit {std::uint64_t {1} << 55};
+}  // namespace
+
+MemoryWatch::MemoryWatch(std::ostream& os) :
+MemoryWatch(currentDumpOptions(), os)
+{}
+
+MemoryWatch::MemoryWatch(const DumpOptions& options, std::ostream& os) :
+options_(options),
+os_(os),
+rowWidth_(options.validRowWidth()),
+pageSize_(static_cast<uptr_t>(::sysconf(_SC_PAGESIZE)))
+{
+  softDirty_ = probeSoftDirty();
+}
+
+MemoryWatch::~MemoryWatch() {
+  stop();
+  if (pagemapFd_ >= 0) {
+    ::close(pagemapFd_);
+  }
+  if (clearRefsFd_ >= 0) {
+    ::close(clearRefsFd_);
+  }
+}
+
+bool MemoryWatch::probeSoftDirty() noexcept {
+  pagemapFd_ = ::open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+  clearRefsFd_ = ::open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+  if ((pagemapFd_ < 0) || (clearRefsFd_ < 0)) {
+    return false;
+  }
+
+  // a page written after clearing the bits must be found soft-dirty
+  auto* const page {static_cast<volatile byte_t*>(::mmap(nullptr, pageSize_, PROT_READ | PROT_WRITE,
+                                                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0))};
+  if (MAP_FAILED == page) {
+    return false;
+  }
+  page[0] = 1;
+  clearSoftDirty();
+  page[0] = 2;
+  std::uint64_t entry {};
+  const off_t offset {static_cast<off_t>(reinterpret_cast<uptr_t>(page) / pageSize_ * sizeof(entry))};
+  const bool supported {(::pread(pagemapFd_, &entry, sizeof(entry), offset) == sizeof(entry)) &&
+                        (0 != (entry & softDirtyBit))};
+  ::munmap(const_cast<byte_t*>(page), pageSize_);
+  return supported;
+}
+
+void MemoryWatch::clearSoftDirty() noexcept {
+  if (::pwrite(clearRefsFd_, "4", 1, 0) != 1) {
+    softDirty_ = false;  // every row is hashed from now on
+  }
+}
+
+bool MemoryWatch::watch(const void* ptr, const std::size_t size, const std::string_view name) noexcept {
+  const std::lock_guard<std::mutex> lock {mutex_};
+  try {
+    Region region {reinterpret_cast<uptr_t>(ptr), size, std::string {name}, {}};
+    const uptr_t firstRow {region.address - region.address % rowWidth_};
+    for (uptr_t row {firstRow}; row < region.address + size; row += rowWidth_) {
+      region.rowHashes.push_back(rowHash(region, row));
+    }
+    regions_.push_back(std::move(region));
+  } catch (...) {
+    std::cerr << "memDump::MemoryWatch::watch: out of memory\n";
+    return false;
+  }
+  return true;
+}
+
+std::uint64_t MemoryWatch::rowHash(const Region& region, const uptr_t rowAddress) const noexcept {
+  const uptr_t begin {std::max(rowAddress, region.address)};
+  const uptr_t end {std::min(rowAddress + rowWidth_, region.address + region.size)};
+  const auto* bytes {reinterpret_cast<const byte_t*>(begin)};
+
+  // a word at a time: the rows are at most 64 bytes
+  std::uint64_t hash {0x9E3779B97F4A7C15 ^ (end - begin)};
+  for (uptr_t left {end - begin}; left > 0;) {
+    std::uint64_t word {0};
+    const uptr_t n {std::min<uptr_t>(left, sizeof(word))};
+    std::memcpy(&word, bytes, n);
+    hash = (hash ^ word) * 0xFF51AFD7ED558CCD;
+    hash ^= hash >> 32;
+    bytes += n;
+    left -= n;
+  }
+  return hash;
+}
+
+std::size_t MemoryWatch::check() noexcept {
+  const std::lock_guard<std::mutex> lock {mutex_};
+
+  // the pagemap entries of all the regions, read before clearing the bits:
+  // the pages written after the clearing are found at the next check
+  bool dirtyKnown {softDirty_};
+  if (dirtyKnown) {
+    std::size_t pages {0};
+    for (const Region& region : regions_) {
+      pages += (region.address + region.size + pageSize_ - 1) / pageSize_ - region.address / pageSize_;
+    }
+    try {
+      pagemap_.resize(pages);
+    } catch (...) {
+      dirtyKnown = false;
+    }
+    std::size_t entry {0};
+    for (const Region& region : regions_) {
+      const uptr_t count {(region.address + region.size + pageSize_ - 1) / pageSize_ - region.address / pageSize_};
+      const ssize_t size {static_cast<ssize_t>(count * sizeof(std::uint64_t))};
+      const off_t offset {static_cast<off_t>(region.address / pageSize_ * sizeof(std::uint64_t))};
+      if (dirtyKnown && (::pread(pagemapFd_, &pagemap_[entry], static_cast<std::size_t>(size), offset) != size)) {
+        dirtyKnown = false;
+      }
+      entry += count;
+    }
+    clearSoftDirty();
+  }
+
+  std::size_t changedRows {0};
+  std::size_t entry {0};
+  for (Region& region : regions_) {
+    const uptr_t end {region.address + region.size};
+    const uptr_t firstPage {region.address / pageSize_};
+    const uptr_t firstRow {region.address - region.address % rowWidth_};
+    std::optional<HighlightRowRenderer> renderer {};
+    std::size_t regionChangedRows {0};
+    uptr_t nextRow {firstRow};  // the rows before it are checked
+    uptr_t lastRow {0};         // printed
+
+    for (uptr_t page {firstPage}; page * pageSize_ < end; ++page, ++entry) {
+      if (dirtyKnown && (0 == (pagemap_[entry] & softDirtyBit))) {
+        continue;
+      }
+      const uptr_t pageEnd {std::min((page + 1) * pageSize_, end)};
+      const uptr_t pageStart {std::max(page * pageSize_, region.address)};
+      uptr_t row {std::max(pageStart - pageStart % rowWidth_, nextRow)};
+      for (; row < pageEnd; row += rowWidth_) {
+        std::uint64_t& previousHash {region.rowHashes[(row - firstRow) / rowWidth_]};
+        const std::uint64_t hash {rowHash(region, row)};
+        if (hash == previousHash) {
+          continue;
+        }
+        previousHash = hash;
+        if (!renderer) {
+          os_ << "[memDump:watch]--------------------------------------------------------\n";
+          if (!region.name.empty()) {
+            os_ << region.name << " - ";
+          }
+          os_ << std::dec << region.size << " bytes at " << reinterpret_cast<const void*>(region.address)
+              << " - rows changed since the last check\n\n";
+          renderer.emplace(options_, os_);
+          renderer->ruler();
+          if (row != firstRow) {
+            renderer->skipped();
+          }
+        } else if (row != lastRow + rowWidth_) {
+          renderer->skipped();
+        }
+        // the whole row is highlighted: only its hash is kept
+        const uptr_t first {std::max(row, region.address) - row};
+        const uptr_t count {std::min(row + rowWidth_, end) - row - first};
+        const std::uint64_t highlighted {((count >= 64) ? ~std::uint64_t {0} : ((std::uint64_t {1} << count) - 1)) << first};
+        renderer->row(row, reinterpret_cast<const byte_t*>(row + first), first, count, highlighted);
+        lastRow = row;
+        ++regionChangedRows;
+      }
+      nextRow = row;
+    }
+    if (renderer) {
+      if (lastRow + rowWidth_ < end) {
+        renderer->skipped();
+      }
+      os_ << "\n" << std::dec << regionChangedRows << ((1 == regionChangedRows) ? " row" : " rows") << " changed"
+          << "\n-----------------------------------------------------------------------\n";
+    }
+    changedRows += regionChangedRows;
+  }
+  return changedRows;
+}
+
+bool MemoryWatch::start(const std::chrono::milliseconds interval) noexcept {
+  if (thread_.joinable()) {
+    return false;
+  }
+  stopping_ = false;
+  try {
+    thread_ = std::thread([this, interval] {
+      std::unique_lock<std::mutex> lock {stopMutex_};
+      while (!stopCondition_.wait_for(lock, interval, [this] { return stopping_; })) {
+        lock.unlock();
+        check();
+        lock.lock();
+      }
+    });
+  } catch (...) {
+    std::cerr << "memDump::MemoryWatch::start: can't start the thread\n";
+    return false;
+  }
+  return true;
+}
+
+void MemoryWatch::stop() noexcept {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    const std::lock_guard<std::mutex> lock {stopMutex_};
+    stopping_ = true;
+  }
+  stopCondition_.notify_all();
+  thread_.join();
+}
+}  // namespace memDump
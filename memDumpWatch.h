@@ -0,0 +1,90 @@
+//
+// memDumpWatch.h
+//
+// Watches of memory regions, printing the rows changed since the last check.
+// The pages written are found with the soft-dirty bits of Linux, so that only
+// their rows are hashed: the regions left alone cost a read of the pagemap
+//
+#pragma once
+
+#include "memDump.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace memDump
+{
+// Soft-dirty bits are cleared for the whole process at each check (writing
+// 4 to /proc/self/clear_refs): one MemoryWatch per process, with all the
+// regions, should use them. Without soft-dirty tracking in the kernel
+// (CONFIG_MEM_SOFT_DIRTY) every row is hashed at each check instead. A write
+// racing with the clearing of the bits is reported at the next write to its
+// page
+class MemoryWatch final {
+public:
+  explicit MemoryWatch(const DumpOptions& options, std::ostream& os = std::cout);
+  explicit MemoryWatch(std::ostream& os = std::cout);
+  // stop()
+  ~MemoryWatch();
+
+  MemoryWatch(const MemoryWatch&) = delete;
+  MemoryWatch& operator=(const MemoryWatch&) = delete;
+
+  // Watch the size bytes at ptr, readable as long as they're watched, from
+  // now on. Return false if out of memory
+  bool watch(const void* ptr, const std::size_t size, const std::string_view name = {}) noexcept;
+
+  template <typename T>
+  bool watch(const T& var) noexcept {
+    return watch(&var, sizeof(var), demangle::typeName<T>());
+  }
+
+  // Print the rows of the regions changed since the last check, each region
+  // with the changed rows highlighted; return the number of rows changed
+  std::size_t check() noexcept;
+
+  // check() every interval on a thread of its own, until stop()
+  bool start(const std::chrono::milliseconds interval) noexcept;
+  void stop() noexcept;
+
+  // the kernel tracks soft-dirty pages
+  bool softDirty() const noexcept {
+    return softDirty_;
+  }
+
+private:
+  struct Region {
+    uptr_t address;
+    std::size_t size;
+    std::string name;
+    std::vector<std::uint64_t> rowHashes;  // of the rows from the one at address
+  };
+
+  // the hash of the bytes of row at rowAddress in region
+  std::uint64_t rowHash(const Region& region, const uptr_t rowAddress) const noexcept;
+  // mark the pages of region written since the last clearing in dirty
+  bool readDirtyPages(const Region& region, std::vector<bool>& dirty) noexcept;
+  void clearSoftDirty() noexcept;
+  bool probeSoftDirty() noexcept;
+
+  const DumpOptions options_;
+  std::ostream& os_;
+  const uptr_t rowWidth_;
+  const uptr_t pageSize_;
+  int pagemapFd_ {-1};
+  int clearRefsFd_ {-1};
+  bool softDirty_ {false};
+  std::mutex mutex_;  // serializes watch() and check()
+  std::vector<Region> regions_;
+  std::vector<std::uint64_t> pagemap_;  // entries of a region, reused
+
+  std::thread thread_;
+  std::mutex stopMutex_;
+  std::condition_variable stopCondition_;
+  bool stopping_ {false};
+};
+}  // namespace memDump